@@ -0,0 +1,57 @@
+#include "arena.h"
+#include <algorithm>
+#include <cstdint>
+
+
+// Offset of the first address at or after base + offset that is a
+// multiple of alignment, which must be a power of two.
+static size_t alignUp(
+    const std::byte* base,
+    const size_t offset,
+    const size_t alignment
+) {
+    const auto address{reinterpret_cast<uintptr_t>(base) + offset};
+    const auto aligned{(address + alignment - 1) & ~(alignment - 1)};
+    return aligned - reinterpret_cast<uintptr_t>(base);
+}
+
+LinearArena::LinearArena(const size_t chunk_size)
+    : chunk_size{chunk_size} {
+}
+
+void* LinearArena::allocate(const size_t size, const size_t alignment) {
+    if (current < chunks.size()) {
+        auto& chunk{chunks[current]};
+        const auto start{alignUp(chunk.data.get(), offset, alignment)};
+        if (start + size <= chunk.size) {
+            offset = start + size;
+            used += size;
+            return chunk.data.get() + start;
+        }
+    }
+    return allocateSlow(size, alignment);
+}
+
+void* LinearArena::allocateSlow(const size_t size, const size_t alignment) {
+    // Move on to the first chunk left over from earlier frames that is
+    // large enough, or grow the list. Chunks are only guaranteed the
+    // default new alignment, so leave room to align the allocation.
+    const auto needed{size + alignment};
+    if (current < chunks.size()) {
+        current++;
+    }
+    while (current < chunks.size() && chunks[current].size < needed) {
+        current++;
+    }
+    if (current == chunks.size()) {
+        const auto new_size{std::max(chunk_size, needed)};
+        auto data{std::make_unique_for_overwrite<std::byte[]>(new_size)};
+        chunks.push_back({std::move(data), new_size});
+        reserved += new_size;
+    }
+    auto& chunk{chunks[current]};
+    const auto start{alignUp(chunk.data.get(), 0, alignment)};
+    offset = start + size;
+    used += size;
+    return chunk.data.get() + start;
+}
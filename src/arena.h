@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Bump allocator for memory that lives until the next reset, such as
+ * the renderer's per-frame structures. Memory comes from a list of
+ * chunks that is kept across resets, so after the first few frames
+ * allocating never touches the global heap.
+ */
+class LinearArena {
+    struct Chunk {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    std::vector<Chunk> chunks{};
+    size_t chunk_size;
+    size_t current{};
+    size_t offset{};
+    size_t used{};
+    size_t reserved{};
+
+    void* allocateSlow(size_t size, size_t alignment);
+
+  public:
+    explicit LinearArena(size_t chunk_size = 64 * 1024);
+
+    void* allocate(size_t size, size_t alignment);
+
+    // Uninitialized storage for count objects that need no destructor.
+    template <typename T>
+    T* allocate(const size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>);
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Release everything allocated since the last reset.
+    void reset() {
+        current = 0;
+        offset = 0;
+        used = 0;
+    }
+
+    // Reset and give the chunks back to the global heap.
+    void release() {
+        reset();
+        chunks.clear();
+        reserved = 0;
+    }
+
+    // Bytes allocated since the last reset, not counting padding.
+    [[nodiscard]]
+    size_t getUsed() const {
+        return used;
+    }
+
+    // Bytes held in chunks.
+    [[nodiscard]]
+    size_t getReserved() const {
+        return reserved;
+    }
+};
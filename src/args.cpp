@@ -0,0 +1,75 @@
+#include "args.h"
+#include <charconv>
+#include <format>
+
+using std::domain_error;
+using std::optional;
+using std::string_view;
+using std::vector;
+
+
+Arguments::Arguments(const int argc, char* argv[]) {
+    args.reserve(argc);
+    for (int i = 0; i < argc; i++) {
+        args.emplace_back(argv[i]);
+    }
+}
+
+optional<size_t> Arguments::findParam(const string_view name) const {
+    // Skip the program name.
+    for (size_t i = 1; i < args.size(); i++) {
+        if (args[i] == name) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+bool Arguments::hasParam(const string_view name) const {
+    return findParam(name).has_value();
+}
+
+optional<string_view> Arguments::getValue(const string_view name) const {
+    const auto param{findParam(name)};
+    if (!param) {
+        return std::nullopt;
+    }
+    const auto value{*param + 1};
+    if (value >= args.size() || args[value].starts_with('-')) {
+        const auto error{std::format("Parameter {} requires a value", name)};
+        throw domain_error{error};
+    }
+    return args[value];
+}
+
+vector<string_view> Arguments::getValues(const string_view name) const {
+    const auto param{findParam(name)};
+    if (!param) {
+        return {};
+    }
+    vector<string_view> values{};
+    for (auto i{*param + 1}; i < args.size(); i++) {
+        if (args[i].starts_with('-')) {
+            break;
+        }
+        values.push_back(args[i]);
+    }
+    return values;
+}
+
+optional<int> Arguments::getInt(const string_view name) const {
+    const auto value{getValue(name)};
+    if (!value) {
+        return std::nullopt;
+    }
+    int i{};
+    const auto end{value->data() + value->size()};
+    const auto [ptr, ec]{std::from_chars(value->data(), end, i)};
+    if (ec != std::errc{} || ptr != end) {
+        const auto error{std::format(
+            "Parameter {} expects a number, got \"{}\"", name, *value
+        )};
+        throw domain_error{error};
+    }
+    return i;
+}
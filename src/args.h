@@ -0,0 +1,34 @@
+#pragma once
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+/**
+ * Read-only view of the command line the engine was started with.
+ * Parameters follow the classic Doom convention of a dash-prefixed
+ * name optionally followed by a value, e.g. "-scale 3".
+ */
+class Arguments {
+    std::vector<std::string_view> args{};
+
+    [[nodiscard]]
+    std::optional<size_t> findParam(std::string_view name) const;
+
+  public:
+    Arguments(int argc, char* argv[]);
+
+    [[nodiscard]]
+    bool hasParam(std::string_view name) const;
+
+    [[nodiscard]]
+    std::optional<std::string_view> getValue(std::string_view name) const;
+
+    // Values following a parameter up to the next one, e.g. the files
+    // of "-file a.wad b.wad".
+    [[nodiscard]]
+    std::vector<std::string_view> getValues(std::string_view name) const;
+
+    [[nodiscard]]
+    std::optional<int> getInt(std::string_view name) const;
+};
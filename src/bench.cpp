@@ -0,0 +1,1306 @@
+#include "bench.h"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <format>
+#include <limits>
+#include <ostream>
+#include <random>
+#include <vector>
+#include "collision.h"
+#include "draw.h"
+#include "game.h"
+#include "level.h"
+#include "mobj.h"
+#include "noise.h"
+#include "planes.h"
+#include "project.h"
+#include "renderer.h"
+#include "sprites.h"
+#include "stats.h"
+#include "window.h"
+#include "workers.h"
+#include "zone.h"
+
+// Step of a walking monster, and the same step along the diagonals.
+static constexpr fixed_t walk_speed{8 * frac_unit};
+static constexpr fixed_t diagonal_speed{47000 * 8};
+
+static constexpr std::array<fixed_t, 8> step_x{
+    walk_speed, diagonal_speed, 0, -diagonal_speed,
+    -walk_speed, -diagonal_speed, 0, diagonal_speed,
+};
+static constexpr std::array<fixed_t, 8> step_y{
+    0, diagonal_speed, walk_speed, diagonal_speed,
+    0, -diagonal_speed, -walk_speed, -diagonal_speed,
+};
+
+// Reach of the mobj queries, that of a rocket blast.
+static constexpr fixed_t query_range{128 * frac_unit};
+
+
+/**
+ * Random inputs of the comparisons. The seed is the same on every run,
+ * so that inputs on which the code differs from its reference come up
+ * again when the comparison is run to debug them.
+ */
+class CheckRandom {
+    std::mt19937 engine{1993};
+
+  public:
+    // Between min and max, both included.
+    template <typename T>
+    T between(const T min, const T max) {
+        return std::uniform_int_distribution<T>{min, max}(engine);
+    }
+
+    // A coordinate within the 8192 map units around the origin, where
+    // the difference of two of them cannot overflow.
+    fixed_t position() {
+        return between(-8192 * frac_unit, 8192 * frac_unit);
+    }
+
+    angle_t angle() {
+        return between<angle_t>(0, std::numeric_limits<angle_t>::max());
+    }
+
+    bool chance(const double probability) {
+        return std::bernoulli_distribution{probability}(engine);
+    }
+};
+
+// Run the reference and then the code it checks, adding their times.
+template <typename Reference, typename Tested>
+static void timeBoth(
+    Comparison& result,
+    Reference reference,
+    Tested tested
+) {
+    Stopwatch stopwatch;
+    reference();
+    result.reference_seconds += stopwatch.lap() / 1000.0;
+    tested();
+    result.seconds += stopwatch.lap() / 1000.0;
+}
+
+// Count the results that differ from those of the reference.
+template <typename Results>
+static void countMismatches(
+    Comparison& result,
+    const Results& reference,
+    const Results& tested
+) {
+    for (size_t i = 0; i < std::ranges::size(reference); i++) {
+        result.mismatches += reference[i] != tested[i];
+    }
+}
+
+void printComparison(
+    std::ostream& out,
+    const std::string_view label,
+    const std::string_view item,
+    const Comparison& result
+) {
+    const auto items{static_cast<double>(result.items)};
+    const auto perItem{[&](const double seconds) {
+        return items > 0 ? seconds * 1e9 / items : 0.0;
+    }};
+    out << std::format(
+        "{}: {} {}s, {:.1f} ns reference and {:.1f} ns per {}, "
+        "{} results differ\n",
+        label,
+        result.items,
+        item,
+        perItem(result.reference_seconds),
+        perItem(result.seconds),
+        item,
+        result.mismatches
+    );
+}
+
+// Texels of the drawing benchmarks: 64 wall columns of 128 texels, the
+// first 64x64 of which double as a flat. Neighbours differ, so that a
+// texel drawn from the wrong place shows.
+static std::vector<Uint8> makeTexels() {
+    std::vector<Uint8> texels(64 * 128);
+    for (size_t i = 0; i < texels.size(); i++) {
+        texels[i] = static_cast<Uint8>(i * 7 + i / 64);
+    }
+    return texels;
+}
+
+// Take a step in the direction kept in the angle, 45 degrees apart, or
+// turn if the step is blocked. Returns whether the mobj moved.
+static bool walkMobj(Level& level, Mobj& mobj, const size_t tic) {
+    const auto direction{mobj.angle / ang45};
+    const auto x{mobj.x + step_x[direction]};
+    const auto y{mobj.y + step_y[direction]};
+    if (tryMove(level, mobj, x, y)) {
+        return true;
+    }
+    const auto turn{1 + (mobj.id + tic) % 7};
+    const auto new_direction{(direction + turn) % 8};
+    mobj.angle = static_cast<angle_t>(new_direction) * ang45;
+    return false;
+}
+
+MoveBenchmark benchmarkMovement(
+    WadManager& wad_manager,
+    const GameSettings& settings,
+    const size_t tics,
+    const bool mobj_grid
+) {
+    Game game{settings, wad_manager};
+    auto& level{game.getLevel()};
+    if (mobj_grid) {
+        level.enableMobjGrid();
+    }
+    MoveBenchmark result{.mobj_grid = mobj_grid, .tics = tics};
+    double milliseconds{0};
+    for (size_t tic = 0; tic < tics; tic++) {
+        Stopwatch stopwatch;
+        if (const auto grid{level.getMobjGrid()}) {
+            grid->update();
+        }
+        level.forEachMobj([&](Mobj& mobj) {
+            result.moves++;
+            result.blocked += !walkMobj(level, mobj, tic);
+        });
+        milliseconds += stopwatch.lap();
+    }
+    result.seconds = milliseconds / 1000.0;
+    return result;
+}
+
+void printMoveBenchmark(std::ostream& out, const MoveBenchmark& result) {
+    const auto moves{static_cast<double>(result.moves)};
+    const auto nanoseconds{moves > 0 ? result.seconds * 1e9 / moves : 0.0};
+    const auto blocked{moves > 0 ? 100.0 * result.blocked / moves : 0.0};
+    const auto tic_time{
+        result.tics > 0 ? result.seconds * 1000.0 / result.tics : 0.0
+    };
+    out << std::format(
+        "{}: {} moves in {} tics: {:.1f} ns per move, {:.3f} ms per tic, "
+        "{:.1f}% blocked\n",
+        result.mobj_grid ? "mobj grid" : "block links",
+        result.moves,
+        result.tics,
+        nanoseconds,
+        tic_time,
+        blocked
+    );
+}
+
+QueryBenchmark benchmarkQueries(
+    WadManager& wad_manager,
+    const GameSettings& settings,
+    const size_t rounds,
+    const bool mobj_grid
+) {
+    Game game{settings, wad_manager};
+    auto& level{game.getLevel()};
+    if (mobj_grid) {
+        level.enableMobjGrid();
+    }
+    const auto& blockmap{level.getBlockmap()};
+    std::vector<Mobj*> found{};
+
+    // Both ways collect the mobjs found into an array, as radius attacks
+    // damage them after the search.
+    const auto findInBlocks{[&](const fixed_t x, const fixed_t y) {
+        found.clear();
+        const auto reach{query_range + max_radius};
+        const auto left{blockmap.blockX(x - reach)};
+        const auto right{blockmap.blockX(x + reach)};
+        const auto bottom{blockmap.blockY(y - reach)};
+        const auto top{blockmap.blockY(y + reach)};
+        for (auto block_y{bottom}; block_y <= top; block_y++) {
+            for (auto block_x{left}; block_x <= right; block_x++) {
+                if (!blockmap.contains(block_x, block_y)) {
+                    continue;
+                }
+                for (auto other{level.firstMobjIn(block_x, block_y)}; other;
+                     other = other->block_next) {
+                    const auto other_reach{query_range + other->radius};
+                    if (std::abs(other->x - x) < other_reach
+                        && std::abs(other->y - y) < other_reach) {
+                        found.push_back(other);
+                    }
+                }
+            }
+        }
+        return found.size();
+    }};
+
+    QueryBenchmark result{.mobj_grid = mobj_grid};
+    Stopwatch stopwatch;
+    for (size_t round = 0; round < rounds; round++) {
+        level.forEachMobj([&](const Mobj& mobj) {
+            result.queries++;
+            if (const auto grid{level.getMobjGrid()}) {
+                result.found += grid->query(mobj.x, mobj.y, query_range).size();
+            } else {
+                result.found += findInBlocks(mobj.x, mobj.y);
+            }
+        });
+    }
+    result.seconds = stopwatch.lap() / 1000.0;
+    return result;
+}
+
+void printQueryBenchmark(std::ostream& out, const QueryBenchmark& result) {
+    const auto queries{static_cast<double>(result.queries)};
+    const auto nanoseconds{queries > 0 ? result.seconds * 1e9 / queries : 0.0};
+    const auto found{
+        queries > 0 ? static_cast<double>(result.found) / queries : 0.0
+    };
+    out << std::format(
+        "{}: {} queries: {:.1f} ns per query, {:.1f} mobjs found per query\n",
+        result.mobj_grid ? "mobj grid" : "block links",
+        result.queries,
+        nanoseconds,
+        found
+    );
+}
+
+SightBenchmark benchmarkSight(
+    WadManager& wad_manager,
+    const GameSettings& settings,
+    const size_t tics,
+    const bool moving,
+    const bool reject,
+    const bool cache
+) {
+    Game game{settings, wad_manager};
+    auto& level{game.getLevel()};
+    if (!reject) {
+        level.disableReject();
+    }
+    if (!cache) {
+        level.disableSightCache();
+    }
+    Mobj* target{nullptr};
+    level.forEachMobj([&](Mobj& mobj) {
+        if (!target || mobj.id < target->id) {
+            target = &mobj;
+        }
+    });
+
+    SightBenchmark result{
+        .moving = moving,
+        .reject = reject,
+        .cache = cache,
+        .tics = tics,
+    };
+    double milliseconds{0};
+    const std::array<TicCmd, max_players> commands{};
+    const auto num_players{
+        static_cast<size_t>(game.getSettings().numPlayers())
+    };
+    for (size_t tic = 0; tic < tics && target; tic++) {
+        game.ticker({commands.data(), num_players});
+        if (moving) {
+            level.forEachMobj([&](Mobj& mobj) { walkMobj(level, mobj, tic); });
+        }
+        Stopwatch stopwatch;
+        level.forEachMobj([&](Mobj& mobj) {
+            if (&mobj != target) {
+                checkSight(level, mobj, *target);
+            }
+        });
+        milliseconds += stopwatch.lap();
+    }
+    result.stats = level.getSightStats();
+    result.seconds = milliseconds / 1000.0;
+    return result;
+}
+
+void printSightBenchmark(std::ostream& out, const SightBenchmark& result) {
+    const auto checks{static_cast<double>(result.stats.checks)};
+    const auto nanoseconds{checks > 0 ? result.seconds * 1e9 / checks : 0.0};
+    out << std::format(
+        "{} lookers, REJECT {}, cache {}: {} tics: {:.1f} ns per sight check\n",
+        result.moving ? "moving" : "standing",
+        result.reject ? "on" : "off",
+        result.cache ? "on" : "off",
+        result.tics,
+        nanoseconds
+    );
+    printSightStats(out, result.stats);
+    if (result.cache) {
+        // Share of the checks that reached the cache and were answered.
+        const auto looked_up{result.stats.cached + result.stats.traced};
+        const auto hit_rate{
+            looked_up > 0 ? 100.0 * static_cast<double>(result.stats.cached)
+                                / static_cast<double>(looked_up)
+                          : 0.0
+        };
+        out << std::format("sight cache hit rate {:.1f}%\n", hit_rate);
+    }
+}
+
+// Where the noise of the recursion reached each sector, kept apart from
+// the sectors so that they still hold what noiseAlert() left.
+struct RecursiveSound {
+    std::vector<std::vector<const Line*>> sector_lines;
+    std::vector<Uint32> stamps;
+    std::vector<int> traversed;
+    std::vector<MobjHandle> targets;
+    Uint32 stamp{0};
+};
+
+// The original P_RecursiveSound, which the flood of noiseAlert() must
+// leave every sector as.
+static void recursiveSound(
+    const Level& level,
+    RecursiveSound& sound,
+    const MobjHandle target,
+    const Uint32 sector,
+    const int sound_blocks
+) {
+    if (sound.stamps[sector] == sound.stamp
+        && sound.traversed[sector] <= sound_blocks + 1) {
+        return;
+    }
+    sound.stamps[sector] = sound.stamp;
+    sound.traversed[sector] = sound_blocks + 1;
+    sound.targets[sector] = target;
+    for (const auto line : sound.sector_lines[sector]) {
+        if ((line->flags & ml_two_sided) == 0 || !line->back_sector) {
+            continue;
+        }
+        const auto& front{*line->front_sector};
+        const auto& back{*line->back_sector};
+        const auto top{std::min(front.ceiling_height, back.ceiling_height)};
+        const auto bottom{std::max(front.floor_height, back.floor_height)};
+        if (top <= bottom) {
+            continue;
+        }
+        const auto other{level.sectorIndex(
+            level.sectorIndex(front) == sector ? back : front
+        )};
+        if ((line->flags & ml_sound_block) == 0) {
+            recursiveSound(level, sound, target, other, sound_blocks);
+        } else if (sound_blocks == 0) {
+            recursiveSound(level, sound, target, other, 1);
+        }
+    }
+}
+
+// Whether a noise reached a sector, and how, for comparing the sectors
+// noiseAlert() left with those of the recursion.
+struct SectorNoise {
+    bool heard;
+    int traversed;
+    MobjHandle target;
+
+    bool operator==(const SectorNoise& other) const = default;
+};
+
+Comparison benchmarkNoise(
+    WadManager& wad_manager,
+    const GameSettings& settings,
+    const size_t rounds
+) {
+    Game game{settings, wad_manager};
+    auto& level{game.getLevel()};
+    const auto sectors{level.getSectors()};
+    RecursiveSound sound{
+        .sector_lines = std::vector<std::vector<const Line*>>(sectors.size()),
+        .stamps = std::vector<Uint32>(sectors.size()),
+        .traversed = std::vector<int>(sectors.size()),
+        .targets = std::vector<MobjHandle>(sectors.size()),
+    };
+    for (const auto& line : level.getLines()) {
+        const auto front{level.sectorIndex(*line.front_sector)};
+        sound.sector_lines[front].push_back(&line);
+        if (line.back_sector && line.back_sector != line.front_sector) {
+            const auto back{level.sectorIndex(*line.back_sector)};
+            sound.sector_lines[back].push_back(&line);
+        }
+    }
+
+    std::vector<fixed_t> ceiling_heights(sectors.size());
+    for (size_t i = 0; i < sectors.size(); i++) {
+        ceiling_heights[i] = sectors[i].ceiling_height;
+    }
+    std::vector<SectorNoise> flooded(sectors.size());
+    std::vector<SectorNoise> recursed(sectors.size());
+    CheckRandom random;
+    Comparison result{};
+    for (size_t round = 0; round < rounds; round++) {
+        // Shut doors cut the noise off, so that it has to find its way
+        // around them, differently every round.
+        for (size_t i = 0; i < sectors.size(); i++) {
+            sectors[i].ceiling_height = random.chance(0.125)
+                                            ? sectors[i].floor_height
+                                            : ceiling_heights[i];
+        }
+        for (Uint32 emitter = 0; emitter < sectors.size(); emitter++) {
+            const MobjHandle target{
+                .index = emitter,
+                .generation = static_cast<Uint32>(round),
+            };
+            timeBoth(
+                result,
+                [&] {
+                    sound.stamp++;
+                    recursiveSound(level, sound, target, emitter, 0);
+                },
+                [&] { noiseAlert(level, target, sectors[emitter]); }
+            );
+
+            const auto flood_stamp{sectors[emitter].sound_stamp};
+            for (size_t i = 0; i < sectors.size(); i++) {
+                const auto& sector{sectors[i]};
+                flooded[i] = {};
+                if (sector.sound_stamp == flood_stamp) {
+                    flooded[i] = {
+                        true, sector.sound_traversed, sector.sound_target
+                    };
+                }
+                recursed[i] = {};
+                if (sound.stamps[i] == sound.stamp) {
+                    recursed[i] = {
+                        true, sound.traversed[i], sound.targets[i]
+                    };
+                }
+            }
+            result.items++;
+            countMismatches(result, recursed, flooded);
+        }
+    }
+    for (size_t i = 0; i < sectors.size(); i++) {
+        sectors[i].ceiling_height = ceiling_heights[i];
+    }
+    return result;
+}
+
+LayoutBenchmark benchmarkLayout(
+    const FrameLayout layout,
+    const int width,
+    const int height,
+    const size_t frames
+) {
+    VideoMode mode{width, height};
+    mode.layout = layout;
+    mode.headless = true;
+    Window window{mode};
+    const auto frame{window.getFrameBuffer()};
+    const Drawer drawer{frame};
+
+    const auto texels{makeTexels()};
+    std::array<Uint8, 256> colormap{};
+    for (size_t i = 0; i < colormap.size(); i++) {
+        colormap[i] = static_cast<Uint8>(i);
+    }
+
+    // Walls cover the middle half of the rows, the rest are spans.
+    const auto wall_top{height / 4};
+    const auto wall_bottom{height - height / 4 - 1};
+    const auto step{frac_unit * native_height / height};
+    LayoutBenchmark result{
+        .layout = layout,
+        .width = width,
+        .height = height,
+        .frames = frames,
+    };
+    double draw_milliseconds{0};
+    double present_milliseconds{0};
+    for (size_t frame_index = 0; frame_index < frames; frame_index++) {
+        const auto offset{static_cast<fixed_t>(frame_index) * frac_unit};
+        Stopwatch stopwatch;
+        for (int x = 0; x < width; x++) {
+            const ColumnDraw column{
+                .x = x,
+                .yl = wall_top,
+                .yh = wall_bottom,
+                .iscale = step,
+                .texture_mid = offset,
+                .source = &texels[(x * native_width / width) % 64 * 128],
+                .colormap = colormap.data(),
+                .lit_palette = nullptr,
+            };
+            drawer.drawColumn(column);
+        }
+        const auto drawFlatRow{[&](const int y) {
+            const SpanDraw span{
+                .y = y,
+                .x1 = 0,
+                .x2 = width - 1,
+                .x_frac = offset,
+                .y_frac = y * step,
+                .x_step = step,
+                .y_step = step / 4,
+                .source = texels.data(),
+                .colormap = colormap.data(),
+                .lit_palette = nullptr,
+            };
+            drawer.drawSpan(span);
+        }};
+        for (int y = 0; y < wall_top; y++) {
+            drawFlatRow(y);
+        }
+        for (int y = wall_bottom + 1; y < height; y++) {
+            drawFlatRow(y);
+        }
+        draw_milliseconds += stopwatch.lap();
+        window.present();
+        present_milliseconds += stopwatch.lap();
+    }
+    result.draw_seconds = draw_milliseconds / 1000.0;
+    result.present_seconds = present_milliseconds / 1000.0;
+    return result;
+}
+
+void printLayoutBenchmark(std::ostream& out, const LayoutBenchmark& result) {
+    const auto frames{static_cast<double>(result.frames)};
+    const auto perFrame{[&](const double seconds) {
+        return frames > 0 ? seconds * 1000.0 / frames : 0.0;
+    }};
+    out << std::format(
+        "{}x{} {}: {:.3f} ms drawing, {:.3f} ms presenting per frame\n",
+        result.width,
+        result.height,
+        result.layout == FrameLayout::ColumnMajor ? "column-major"
+                                                  : "row-major",
+        perFrame(result.draw_seconds),
+        perFrame(result.present_seconds)
+    );
+}
+
+// Floor or ceiling as the original kept it in its visplane array.
+struct ReferencePlane {
+    fixed_t height;
+    int picnum;
+    int light_level;
+    int min_x;
+    int max_x;
+    // Rows of every column of the view, with a guard column on each side.
+    std::vector<Uint16> tops;
+    std::vector<Uint16> bottoms;
+};
+
+/**
+ * Visplanes found by the linear search of the original R_FindPlane and
+ * R_CheckPlane, over a view of the given width, and turned into spans
+ * as R_MakeSpans does. The planes of a frame reuse the rows of those of
+ * earlier frames.
+ */
+class ReferencePlanes {
+    int width;
+    std::vector<ReferencePlane> planes{};
+    size_t num_planes{0};
+    std::vector<int> span_start;
+
+    size_t newPlane(const fixed_t height, const int picnum, const int light) {
+        if (num_planes == planes.size()) {
+            planes.emplace_back();
+        }
+        auto& plane{planes[num_planes]};
+        plane.height = height;
+        plane.picnum = picnum;
+        plane.light_level = light;
+        plane.min_x = width;
+        plane.max_x = -1;
+        plane.tops.assign(width + 2, unused_row);
+        plane.bottoms.assign(width + 2, 0);
+        return num_planes++;
+    }
+
+  public:
+    ReferencePlanes(const int width, const int height)
+        : width{width}
+        , span_start(height) {
+    }
+
+    void clear() {
+        num_planes = 0;
+    }
+
+    [[nodiscard]]
+    std::span<const ReferencePlane> getPlanes() const {
+        return {planes.data(), num_planes};
+    }
+
+    size_t findPlane(const fixed_t height, const int picnum, const int light) {
+        for (size_t i = 0; i < num_planes; i++) {
+            const auto& plane{planes[i]};
+            if (plane.height == height
+                && plane.picnum == picnum
+                && plane.light_level == light) {
+                return i;
+            }
+        }
+        return newPlane(height, picnum, light);
+    }
+
+    size_t checkPlane(const size_t index, const int start, const int stop) {
+        auto& plane{planes[index]};
+        const auto intersect_low{std::max(start, plane.min_x)};
+        const auto intersect_high{std::min(stop, plane.max_x)};
+        auto x{intersect_low};
+        while (x <= intersect_high && plane.tops[x + 1] == unused_row) {
+            x++;
+        }
+        if (x > intersect_high) {
+            plane.min_x = std::min(start, plane.min_x);
+            plane.max_x = std::max(stop, plane.max_x);
+            return index;
+        }
+        const auto split{
+            newPlane(plane.height, plane.picnum, plane.light_level)
+        };
+        planes[split].min_x = start;
+        planes[split].max_x = stop;
+        return split;
+    }
+
+    void setRows(
+        const size_t index,
+        const int x,
+        const int top,
+        const int bottom
+    ) {
+        planes[index].tops[x + 1] = static_cast<Uint16>(top);
+        planes[index].bottoms[x + 1] = static_cast<Uint16>(bottom);
+    }
+
+    template <typename MapSpan>
+    void drawPlanes(MapSpan map_span) {
+        for (size_t i = 0; i < num_planes; i++) {
+            auto& plane{planes[i]};
+            if (plane.min_x > plane.max_x) {
+                continue;
+            }
+            plane.tops[plane.min_x] = unused_row;
+            plane.tops[plane.max_x + 2] = unused_row;
+            for (auto x = plane.min_x; x <= plane.max_x + 1; x++) {
+                int t1{plane.tops[x]};
+                int b1{plane.bottoms[x]};
+                int t2{plane.tops[x + 1]};
+                int b2{plane.bottoms[x + 1]};
+                for (; t1 < t2 && t1 <= b1; t1++) {
+                    map_span(i, t1, span_start[t1], x - 1);
+                }
+                for (; b1 > b2 && b1 >= t1; b1--) {
+                    map_span(i, b1, span_start[b1], x - 1);
+                }
+                for (; t2 < t1 && t2 <= b2; t2++) {
+                    span_start[t2] = x;
+                }
+                for (; b2 > b1 && b2 >= t2; b2--) {
+                    span_start[b2] = x;
+                }
+            }
+        }
+    }
+};
+
+// Span of a plane, by the index of the plane in the order planes were
+// made, which both the reference and VisplaneSet make them in.
+struct PlaneSpan {
+    size_t plane;
+    int y;
+    int x1;
+    int x2;
+
+    bool operator==(const PlaneSpan& other) const = default;
+};
+
+// Wall whose floor asks for a plane over columns [start, stop], with
+// rows that slope from (top, bottom) by the given steps per column.
+struct PlaneRequest {
+    fixed_t height;
+    int picnum;
+    int light_level;
+    int start;
+    int stop;
+    int top;
+    int bottom;
+    int top_step;
+    int bottom_step;
+};
+
+Comparison benchmarkPlanes(
+    const int width,
+    const int height,
+    const size_t frames
+) {
+    Zone zone;
+    FrameArena frame_arena{zone};
+    VisplaneSet set;
+    ReferencePlanes reference{width, height};
+
+    // Few enough surfaces that walls keep asking for planes that exist,
+    // over columns that other walls of the surface often took already,
+    // which makes the planes split. Rows cross over as they slope, so
+    // that some columns are left out of the plane.
+    CheckRandom random;
+    const auto num_requests{static_cast<size_t>(width)};
+    std::vector<PlaneRequest> requests(num_requests);
+    std::vector<size_t> reference_found(num_requests);
+    std::vector<Visplane*> found(num_requests);
+    std::vector<PlaneSpan> reference_spans{};
+    std::vector<PlaneSpan> spans{};
+    std::vector<const Visplane*> span_planes{};
+    const auto rowsAt{[&](const PlaneRequest& request, const int x) {
+        const auto columns{x - request.start};
+        const auto top{request.top + request.top_step * columns};
+        const auto bottom{request.bottom + request.bottom_step * columns};
+        return std::pair{
+            std::clamp(top, 0, height - 1), std::clamp(bottom, 0, height - 1)
+        };
+    }};
+    Comparison result{};
+    for (size_t frame = 0; frame < frames; frame++) {
+        for (auto& request : requests) {
+            const auto start{random.between(0, width - 1)};
+            request = {
+                .height = random.between(0, 7) * 16 * frac_unit,
+                .picnum = random.between(0, 7),
+                .light_level = random.between(0, 3) * 64,
+                .start = start,
+                .stop = std::min(start + random.between(0, 63), width - 1),
+                .top = random.between(0, height - 1),
+                .bottom = random.between(0, height - 1),
+                .top_step = random.between(-2, 2),
+                .bottom_step = random.between(-2, 2),
+            };
+        }
+
+        reference_spans.clear();
+        spans.clear();
+        span_planes.clear();
+        timeBoth(
+            result,
+            [&] {
+                reference.clear();
+                for (size_t i = 0; i < num_requests; i++) {
+                    const auto& request{requests[i]};
+                    const auto plane{reference.checkPlane(
+                        reference.findPlane(
+                            request.height, request.picnum, request.light_level
+                        ),
+                        request.start,
+                        request.stop
+                    )};
+                    reference_found[i] = plane;
+                    for (auto x = request.start; x <= request.stop; x++) {
+                        const auto [top, bottom]{rowsAt(request, x)};
+                        if (top <= bottom) {
+                            reference.setRows(plane, x, top, bottom);
+                        }
+                    }
+                }
+                reference.drawPlanes(
+                    [&](const size_t plane, const int y, const int x1,
+                        const int x2) {
+                        reference_spans.push_back({plane, y, x1, x2});
+                    }
+                );
+            },
+            [&] {
+                set.clear(frame_arena.beginFrame(), 0, width, height);
+                for (size_t i = 0; i < num_requests; i++) {
+                    const auto& request{requests[i]};
+                    const auto plane{set.checkPlane(
+                        set.findPlane(
+                            request.height, request.picnum, request.light_level
+                        ),
+                        request.start,
+                        request.stop
+                    )};
+                    found[i] = plane;
+                    for (auto x = request.start; x <= request.stop; x++) {
+                        const auto [top, bottom]{rowsAt(request, x)};
+                        if (top <= bottom) {
+                            plane->top(x) = static_cast<Uint16>(top);
+                            plane->bottom(x) = static_cast<Uint16>(bottom);
+                        }
+                    }
+                }
+                set.drawPlanes(
+                    [&](const Visplane& plane, const int y, const int x1,
+                        const int x2) {
+                        span_planes.push_back(&plane);
+                        spans.push_back({0, y, x1, x2});
+                    }
+                );
+            }
+        );
+        result.items += num_requests;
+
+        // Planes are told apart by the order they were made in.
+        const auto planes{set.getPlanes()};
+        const auto indexOf{[&](const Visplane* plane) {
+            const auto found_plane{std::ranges::find(planes, plane)};
+            return static_cast<size_t>(found_plane - planes.begin());
+        }};
+        std::vector<size_t> found_indexes(num_requests);
+        for (size_t i = 0; i < num_requests; i++) {
+            found_indexes[i] = indexOf(found[i]);
+        }
+        countMismatches(result, reference_found, found_indexes);
+        for (size_t i = 0; i < spans.size(); i++) {
+            spans[i].plane = indexOf(span_planes[i]);
+        }
+        const auto reference_planes{reference.getPlanes()};
+        result.mismatches += reference_planes.size() != planes.size();
+        result.mismatches += reference_spans.size() != spans.size();
+        if (reference_planes.size() != planes.size()
+            || reference_spans.size() != spans.size()) {
+            continue;
+        }
+        countMismatches(result, reference_spans, spans);
+        for (size_t i = 0; i < planes.size(); i++) {
+            const auto& expected{reference_planes[i]};
+            const auto& plane{*planes[i]};
+            result.mismatches += plane.height != expected.height
+                                 || plane.picnum != expected.picnum
+                                 || plane.light_level != expected.light_level
+                                 || plane.min_x != expected.min_x
+                                 || plane.max_x != expected.max_x;
+        }
+    }
+    return result;
+}
+
+// Sprites in the order the selection sort of the original R_SortVisSprites
+// draws them: by increasing scale, the first one found on ties.
+static void selectionSort(
+    const std::vector<Vissprite>& sprites,
+    std::vector<size_t>& sorted
+) {
+    std::vector<bool> done(sprites.size());
+    sorted.clear();
+    for (size_t count = 0; count < sprites.size(); count++) {
+        auto best{sprites.size()};
+        for (size_t i = 0; i < sprites.size(); i++) {
+            if (!done[i]
+                && (best == sprites.size()
+                    || sprites[i].scale < sprites[best].scale)) {
+                best = i;
+            }
+        }
+        done[best] = true;
+        sorted.push_back(best);
+    }
+}
+
+// Clip rows of a sprite as the original R_DrawSprite finds them, walking
+// every drawseg of the frame from the last drawn.
+template <typename DrawMasked>
+static void clipSpriteLinearly(
+    const std::vector<Drawseg>& drawsegs,
+    const Vissprite& sprite,
+    short* clip_top,
+    short* clip_bottom,
+    const int view_height,
+    DrawMasked draw_masked
+) {
+    const auto width{sprite.x2 - sprite.x1 + 1};
+    std::fill_n(clip_top, width, unclipped);
+    std::fill_n(clip_bottom, width, unclipped);
+    for (auto i{drawsegs.size()}; i-- > 0;) {
+        const auto& ds{drawsegs[i]};
+        if (ds.x1 > sprite.x2
+            || ds.x2 < sprite.x1
+            || (!ds.silhouette && !ds.masked_texture_col)) {
+            continue;
+        }
+        const auto r1{std::max(ds.x1, sprite.x1)};
+        const auto r2{std::min(ds.x2, sprite.x2)};
+        const auto scale{std::max(ds.scale1, ds.scale2)};
+        const auto low_scale{std::min(ds.scale1, ds.scale2)};
+        if (scale < sprite.scale
+            || (low_scale < sprite.scale
+                && !pointOnSegSide(sprite.gx, sprite.gy, ds))) {
+            if (ds.masked_texture_col) {
+                draw_masked(ds, r1, r2);
+            }
+            continue;
+        }
+        auto silhouette{ds.silhouette};
+        if (sprite.gz >= ds.bottom_sil_height) {
+            silhouette &= ~silhouette_bottom;
+        }
+        if (sprite.gzt <= ds.top_sil_height) {
+            silhouette &= ~silhouette_top;
+        }
+        for (auto x = r1; x <= r2; x++) {
+            if ((silhouette & silhouette_bottom)
+                && clip_bottom[x - sprite.x1] == unclipped) {
+                clip_bottom[x - sprite.x1] = ds.sprite_bottom_clip[x - ds.x1];
+            }
+            if ((silhouette & silhouette_top)
+                && clip_top[x - sprite.x1] == unclipped) {
+                clip_top[x - sprite.x1] = ds.sprite_top_clip[x - ds.x1];
+            }
+        }
+    }
+    for (int x = 0; x < width; x++) {
+        if (clip_bottom[x] == unclipped) {
+            clip_bottom[x] = static_cast<short>(view_height);
+        }
+        if (clip_top[x] == unclipped) {
+            clip_top[x] = -1;
+        }
+    }
+}
+
+// Masked column drawn before a sprite, by the drawseg it belongs to.
+struct MaskedColumn {
+    int x;
+    size_t drawseg;
+
+    bool operator==(const MaskedColumn& other) const = default;
+};
+
+Comparison benchmarkSprites(
+    const int width,
+    const int height,
+    const size_t sprites_per_frame,
+    const size_t frames
+) {
+    Zone zone;
+    FrameArena frame_arena{zone};
+    VisspriteList list;
+    DrawsegBins bins;
+
+    // Drawsegs of every kind, some with a masked texture, over a view
+    // crowded with sprites of random depths. The scales come from few
+    // values, so that the sort meets ties it has to keep in order.
+    CheckRandom random;
+    const auto max_drawsegs{static_cast<size_t>(width)};
+    std::vector<Drawseg> drawsegs{};
+    std::vector<short> clip_rows(max_drawsegs * 2 * width);
+    std::vector<Vissprite> sprites(sprites_per_frame);
+    std::vector<size_t> reference_order{};
+    std::span<Vissprite* const> sorted{};
+    std::vector<size_t> order(sprites_per_frame);
+    const auto clip_size{sprites_per_frame * width};
+    std::vector<short> reference_clips(2 * clip_size);
+    std::vector<short> clips(2 * clip_size);
+    std::vector<MaskedColumn> reference_masked{};
+    std::vector<MaskedColumn> masked{};
+    const auto randomScale{[&] {
+        return random.between(1, 256) * (frac_unit / 64);
+    }};
+    Comparison result{};
+    for (size_t frame = 0; frame < frames; frame++) {
+        drawsegs.resize(random.between(size_t{0}, max_drawsegs));
+        for (size_t i = 0; i < drawsegs.size(); i++) {
+            const auto x1{random.between(0, width - 1)};
+            const auto rows{clip_rows.data() + i * 2 * width};
+            for (int x = 0; x < 2 * width; x++) {
+                rows[x] = static_cast<short>(random.between(-1, height));
+            }
+            drawsegs[i] = {
+                .x1 = x1,
+                .x2 = std::min(x1 + random.between(0, 199), width - 1),
+                .scale1 = randomScale(),
+                .scale2 = randomScale(),
+                .line_x = random.position(),
+                .line_y = random.position(),
+                .line_dx = random.between(-1024, 1024) * frac_unit,
+                .line_dy = random.between(-1024, 1024) * frac_unit,
+                .silhouette = random.between(0, 3),
+                .bottom_sil_height = random.between(-64, 64) * frac_unit,
+                .top_sil_height = random.between(0, 128) * frac_unit,
+                .sprite_top_clip = rows,
+                .sprite_bottom_clip = rows + width,
+                .masked_texture_col = random.chance(0.25) ? rows : nullptr,
+            };
+        }
+        for (size_t i = 0; i < sprites.size(); i++) {
+            const auto x1{random.between(0, width - 1)};
+            const auto gz{random.between(-64, 64) * frac_unit};
+            // The patch tells the sprites apart once sorted.
+            sprites[i] = {
+                .x1 = x1,
+                .x2 = std::min(x1 + random.between(0, 99), width - 1),
+                .gx = random.position(),
+                .gy = random.position(),
+                .gz = gz,
+                .gzt = gz + random.between(16, 128) * frac_unit,
+                .scale = randomScale(),
+                .patch = static_cast<int>(i),
+            };
+        }
+
+        reference_masked.clear();
+        masked.clear();
+        timeBoth(
+            result,
+            [&] {
+                selectionSort(sprites, reference_order);
+                for (size_t i = 0; i < sprites.size(); i++) {
+                    const auto& sprite{sprites[reference_order[i]]};
+                    const auto clip_top{reference_clips.data() + i * width};
+                    clipSpriteLinearly(
+                        drawsegs,
+                        sprite,
+                        clip_top,
+                        clip_top + clip_size,
+                        height,
+                        [&](const Drawseg& ds, const int x1, const int x2) {
+                            const auto index{
+                                static_cast<size_t>(&ds - drawsegs.data())
+                            };
+                            for (auto x = x1; x <= x2; x++) {
+                                reference_masked.push_back({x, index});
+                            }
+                        }
+                    );
+                }
+            },
+            [&] {
+                auto& arena{frame_arena.beginFrame()};
+                list.clear(arena);
+                for (const auto& sprite : sprites) {
+                    *list.newSprite() = sprite;
+                }
+                sorted = list.sort();
+                bins.build(arena, drawsegs, 0, width);
+                for (size_t i = 0; i < sorted.size(); i++) {
+                    const auto clip_top{clips.data() + i * width};
+                    bins.clipSprite(
+                        *sorted[i],
+                        clip_top,
+                        clip_top + clip_size,
+                        height,
+                        [&](const Drawseg& ds, const int x1, const int x2) {
+                            const auto index{
+                                static_cast<size_t>(&ds - drawsegs.data())
+                            };
+                            for (auto x = x1; x <= x2; x++) {
+                                masked.push_back({x, index});
+                            }
+                        }
+                    );
+                }
+            }
+        );
+        result.items += sprites.size();
+
+        for (size_t i = 0; i < sorted.size(); i++) {
+            order[i] = static_cast<size_t>(sorted[i]->patch);
+        }
+        countMismatches(result, reference_order, order);
+        for (size_t i = 0; i < sprites.size(); i++) {
+            const auto columns{sprites[reference_order[i]].x2
+                               - sprites[reference_order[i]].x1 + 1};
+            const auto start{i * width};
+            for (const auto offset : {start, start + clip_size}) {
+                result.mismatches += !std::equal(
+                    reference_clips.begin() + offset,
+                    reference_clips.begin() + offset + columns,
+                    clips.begin() + offset
+                );
+            }
+        }
+        // The bins visit a sprite's columns a bin at a time rather than a
+        // drawseg at a time, but every column meets the same drawsegs in
+        // the same order.
+        std::ranges::stable_sort(reference_masked, {}, &MaskedColumn::x);
+        std::ranges::stable_sort(masked, {}, &MaskedColumn::x);
+        result.mismatches += reference_masked != masked;
+    }
+    return result;
+}
+
+// Frame drawn into pixels, which are large enough for true color.
+static FrameBuffer pixelFrame(
+    std::vector<Uint32>& pixels,
+    const int width,
+    const int height,
+    const bool true_color
+) {
+    const auto data{reinterpret_cast<Uint8*>(pixels.data())};
+    const auto layout{FrameLayout::RowMajor};
+    return FrameBuffer{data, width, height, width, layout, true_color};
+}
+
+Comparison benchmarkStrips(
+    WorkerGroup& workers,
+    const int width,
+    const int height,
+    const size_t frames,
+    const bool balance
+) {
+    const auto num_pixels{static_cast<size_t>(width) * height};
+    std::vector<Uint32> single_pixels(num_pixels);
+    std::vector<Uint32> strip_pixels(num_pixels);
+    Zone zone;
+    WorkerGroup single_worker{1};
+    Renderer single{
+        pixelFrame(single_pixels, width, height, false), single_worker, zone
+    };
+    Renderer renderer{
+        pixelFrame(strip_pixels, width, height, false), workers, zone
+    };
+    renderer.setBalancing(balance);
+
+    // A quarter of the view costs sixteen walls a column, and the band
+    // moves right by a column a frame, so that the strips it overlaps
+    // keep changing. Each wall is drawn a texel further down than the
+    // last, so that every one of them leaves its mark.
+    const auto texels{makeTexels()};
+    std::array<Uint8, 256> colormap{};
+    for (size_t i = 0; i < colormap.size(); i++) {
+        colormap[i] = static_cast<Uint8>(i);
+    }
+    size_t frame_index{0};
+    const auto drawWalls{[&](const Drawer& drawer, const int x) {
+        const auto band_start{static_cast<int>(frame_index % width)};
+        const auto in_band{(x - band_start + width) % width < width / 4};
+        const auto walls{in_band ? 16 : 1};
+        for (int wall = 0; wall < walls; wall++) {
+            drawer.drawColumn({
+                .x = x,
+                .yl = 0,
+                .yh = height - 1,
+                .iscale = frac_unit * native_height / height,
+                .texture_mid = wall * frac_unit,
+                .source = &texels[x % 64 * 128],
+                .colormap = colormap.data(),
+                .lit_palette = nullptr,
+            });
+        }
+    }};
+    single.setColumnWork(drawWalls);
+    renderer.setColumnWork(drawWalls);
+
+    Comparison result{};
+    for (; frame_index < frames; frame_index++) {
+        timeBoth(
+            result,
+            [&] { single.renderFrame(); },
+            [&] { renderer.renderFrame(); }
+        );
+        result.items++;
+        countMismatches(result, single_pixels, strip_pixels);
+    }
+    return result;
+}
+
+Comparison benchmarkSpans(
+    const int width,
+    const int height,
+    const bool true_color,
+    const size_t frames
+) {
+    // Both drawers get a buffer large enough for either pixel type.
+    const auto num_pixels{static_cast<size_t>(width) * height};
+    std::vector<Uint32> scalar_pixels(num_pixels);
+    std::vector<Uint32> vector_pixels(num_pixels);
+    const auto scalar_frame{
+        pixelFrame(scalar_pixels, width, height, true_color)
+    };
+    const auto vector_frame{
+        pixelFrame(vector_pixels, width, height, true_color)
+    };
+    const Drawer drawer{vector_frame};
+
+    const auto flat{makeTexels()};
+    std::array<Uint8, 256> colormap{};
+    std::array<Uint32, 256> lit_palette{};
+    for (size_t i = 0; i < colormap.size(); i++) {
+        colormap[i] = static_cast<Uint8>(255 - i);
+        lit_palette[i] = static_cast<Uint32>(i * 0x010203);
+    }
+
+    // One span of any length per row and frame. Steps of up to two
+    // texels keep the texture position from overflowing along a span of
+    // the widest frame.
+    CheckRandom random;
+    const auto anyStep{[&] {
+        return random.between(-2 * frac_unit, 2 * frac_unit);
+    }};
+    std::vector<SpanDraw> spans(height);
+    Comparison result{};
+    for (size_t frame_index = 0; frame_index < frames; frame_index++) {
+        for (int y = 0; y < height; y++) {
+            auto x1{random.between(0, width - 1)};
+            auto x2{random.between(0, width - 1)};
+            if (x2 < x1) {
+                std::swap(x1, x2);
+            }
+            spans[y] = {
+                .y = y,
+                .x1 = x1,
+                .x2 = x2,
+                .x_frac = random.position(),
+                .y_frac = random.position(),
+                .x_step = anyStep(),
+                .y_step = anyStep(),
+                .source = flat.data(),
+                .colormap = colormap.data(),
+                .lit_palette = lit_palette.data(),
+            };
+        }
+
+        timeBoth(
+            result,
+            [&] {
+                for (const auto& span : spans) {
+                    drawSpanScalar(scalar_frame, span);
+                }
+            },
+            [&] {
+                for (const auto& span : spans) {
+                    drawer.drawSpan(span);
+                }
+            }
+        );
+        result.items += spans.size();
+        countMismatches(result, scalar_pixels, vector_pixels);
+    }
+    return result;
+}
+
+Comparison benchmarkProjection(const size_t points, const size_t rounds) {
+    std::vector<fixed_t> xs(points);
+    std::vector<fixed_t> ys(points);
+    std::vector<fixed_t> scalar_txs(points);
+    std::vector<fixed_t> scalar_tzs(points);
+    std::vector<fixed_t> scalar_scales(points);
+    std::vector<fixed_t> vector_txs(points);
+    std::vector<fixed_t> vector_tzs(points);
+    std::vector<fixed_t> vector_scales(points);
+
+    // Every round looks from a new place in a new direction, so that the
+    // points land on both sides of the view and behind it.
+    CheckRandom random;
+    const auto projection{native_width / 2 * frac_unit};
+    Comparison result{};
+    for (size_t round = 0; round < rounds; round++) {
+        const auto view_x{random.position()};
+        const auto view_y{random.position()};
+        const ViewPoint view{view_x, view_y, random.angle()};
+        for (size_t i = 0; i < points; i++) {
+            xs[i] = random.position();
+            ys[i] = random.position();
+        }
+
+        timeBoth(
+            result,
+            [&] {
+                transformPointsScalar(view, xs, ys, scalar_txs, scalar_tzs);
+                for (size_t i = 0; i < points; i++) {
+                    scalar_scales[i] = fixedDiv(projection, scalar_tzs[i]);
+                }
+            },
+            [&] {
+                transformPoints(view, xs, ys, vector_txs, vector_tzs);
+                projectScales(projection, vector_tzs, vector_scales);
+            }
+        );
+        result.items += points;
+        countMismatches(result, scalar_txs, vector_txs);
+        countMismatches(result, scalar_tzs, vector_tzs);
+        countMismatches(result, scalar_scales, vector_scales);
+    }
+    return result;
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <SDL.h>
+#include <iosfwd>
+#include <string_view>
+#include "sight.h"
+#include "video.h"
+
+class WadManager;
+class WorkerGroup;
+struct GameSettings;
+
+/**
+ * Outcome of running the same inputs through code of the game and
+ * through a plainer reference that it must agree with.
+ */
+struct Comparison {
+    // Inputs both ran, and results that differed from the reference.
+    size_t items{};
+    size_t mismatches{};
+    double reference_seconds{};
+    double seconds{};
+};
+
+// Print the time per item of both, and how many results differed.
+void printComparison(
+    std::ostream& out,
+    std::string_view label,
+    std::string_view item,
+    const Comparison& result
+);
+
+// Outcome of the movement benchmark.
+struct MoveBenchmark {
+    bool mobj_grid{};
+    size_t tics{};
+    size_t moves{};
+    size_t blocked{};
+    double seconds{};
+};
+
+/**
+ * Walk every mobj of the level like a monster chasing nothing: a step
+ * in one of eight directions every tic, turning whenever the step is
+ * blocked. Only the moves are timed, so this measures collision checks
+ * against the blockmap and nothing else. The mobjs that may block a move
+ * are found in the blocks, or in a MobjGrid if mobj_grid is set.
+ */
+MoveBenchmark benchmarkMovement(
+    WadManager& wad_manager,
+    const GameSettings& settings,
+    size_t tics,
+    bool mobj_grid
+);
+
+void printMoveBenchmark(std::ostream& out, const MoveBenchmark& result);
+
+// Outcome of the mobj query benchmark.
+struct QueryBenchmark {
+    bool mobj_grid{};
+    size_t queries{};
+    size_t found{};
+    double seconds{};
+};
+
+/**
+ * Find the mobjs around every mobj of the level, within the reach of a
+ * rocket blast, the way radius attacks and target searches do, either
+ * by following the thing links of the blocks or from a MobjGrid.
+ */
+QueryBenchmark benchmarkQueries(
+    WadManager& wad_manager,
+    const GameSettings& settings,
+    size_t rounds,
+    bool mobj_grid
+);
+
+void printQueryBenchmark(std::ostream& out, const QueryBenchmark& result);
+
+// Outcome of the sight benchmark.
+struct SightBenchmark {
+    bool moving{};
+    bool reject{};
+    bool cache{};
+    size_t tics{};
+    SightStats stats{};
+    double seconds{};
+};
+
+/**
+ * Have every mobj of the level look for the first one once a tic, as
+ * monsters looking for a target do. If moving is set, the mobjs first
+ * walk as in benchmarkMovement(), so that lookers and target change
+ * places and sectors between tics.
+ * The REJECT lump and the sight cache answer checks only if reject and
+ * cache are set. Only the sight checks are timed.
+ */
+SightBenchmark benchmarkSight(
+    WadManager& wad_manager,
+    const GameSettings& settings,
+    size_t tics,
+    bool moving,
+    bool reject,
+    bool cache
+);
+
+void printSightBenchmark(std::ostream& out, const SightBenchmark& result);
+
+Comparison benchmarkNoise(
+    WadManager& wad_manager,
+    const GameSettings& settings,
+    size_t rounds
+);
+
+// Outcome of the render buffer layout benchmark.
+struct LayoutBenchmark {
+    FrameLayout layout{};
+    int width{};
+    int height{};
+    size_t frames{};
+    double draw_seconds{};
+    double present_seconds{};
+};
+
+/**
+ * Draw frames of wall columns between ceiling and floor spans into a
+ * headless window of the given size and layout, and present them. The
+ * drawing and the presenting, which transposes a column-major buffer,
+ * are timed separately.
+ */
+LayoutBenchmark benchmarkLayout(
+    FrameLayout layout,
+    int width,
+    int height,
+    size_t frames
+);
+
+void printLayoutBenchmark(std::ostream& out, const LayoutBenchmark& result);
+
+/**
+ * Render frames with the strips of a Renderer on the workers, and with
+ * a single strip, giving each column a wall to draw as often as a band
+ * of expensive columns that moves across the view says. The strips are
+ * rebalanced every frame if balance is set. Both renders are timed per
+ * frame, and compared pixel by pixel.
+ */
+Comparison benchmarkStrips(
+    WorkerGroup& workers,
+    int width,
+    int height,
+    size_t frames,
+    bool balance
+);
+
+/**
+ * Make the visplanes of random walls over a view of the given size with
+ * VisplaneSet and with the linear search of the original, and turn them
+ * into spans. Both are timed per plane request, and the planes found,
+ * their surfaces and columns, and the spans are compared.
+ */
+Comparison benchmarkPlanes(int width, int height, size_t frames);
+
+/**
+ * Sort the given number of random sprites per frame and clip them by
+ * random drawsegs, with VisspriteList and DrawsegBins and with the
+ * selection sort and the walk over every drawseg of the original. Both
+ * are timed per sprite, and the drawing order, the clip rows and the
+ * masked columns drawn before each sprite are compared.
+ */
+Comparison benchmarkSprites(
+    int width,
+    int height,
+    size_t sprites_per_frame,
+    size_t frames
+);
+
+/**
+ * Draw the same random spans, of every length and with any steps, with
+ * the scalar span drawer and with the one the renderer uses, which is
+ * vectorized where the target supports it. Both are timed, and the
+ * frames they drew are compared pixel by pixel.
+ */
+Comparison benchmarkSpans(
+    int width,
+    int height,
+    bool true_color,
+    size_t frames
+);
+
+/**
+ * Move random points into the space of random views and scale them by
+ * their depth, one point at a time and with the vectorized
+ * transformPoints(), rounds times over the same number of points. Both
+ * are timed, and what they computed is compared point by point.
+ */
+Comparison benchmarkProjection(size_t points, size_t rounds);
@@ -0,0 +1,50 @@
+#include "blockmap.h"
+#include "lump.h"
+#include "zone.h"
+
+using std::domain_error;
+
+// Ends the line list of a block.
+static constexpr Uint16 end_of_block{0xffff};
+
+
+Blockmap::Blockmap(ZoneArena& arena, LumpReader reader, const size_t num_lines)
+    : origin_x{reader.readShort() * frac_unit}
+    , origin_y{reader.readShort() * frac_unit}
+    , width{reader.readShort()}
+    , height{reader.readShort()} {
+    if (width < 0 || height < 0) {
+        throw domain_error{"Blockmap has a negative size"};
+    }
+    const auto num_blocks{static_cast<size_t>(width) * height};
+    const auto offsets_start{reader.tell()};
+
+    // Count the lines first, so that both arrays are allocated once. The
+    // offsets are unsigned, which is how large maps get by. Every list
+    // starts with a 0 the original read as line 0, and so does this.
+    const auto readList{[&](const size_t block, auto&& add_line) {
+        reader.seek(offsets_start + 2 * block);
+        const auto offset{static_cast<Uint16>(reader.readShort())};
+        reader.seek(2 * static_cast<size_t>(offset));
+        for (auto line{static_cast<Uint16>(reader.readShort())};
+             line != end_of_block;
+             line = static_cast<Uint16>(reader.readShort())) {
+            if (line >= num_lines) {
+                throw domain_error{"Blockmap refers to a missing line"};
+            }
+            add_line(line);
+        }
+    }};
+    block_starts = arena.allocateArray<Uint32>(num_blocks + 1);
+    Uint32 count{0};
+    for (size_t block = 0; block < num_blocks; block++) {
+        block_starts[block] = count;
+        readList(block, [&](Uint16) { count++; });
+    }
+    block_starts[num_blocks] = count;
+    block_lines = arena.allocateArray<Uint32>(count);
+    for (size_t block = 0; block < num_blocks; block++) {
+        auto next{block_starts[block]};
+        readList(block, [&](const Uint16 line) { block_lines[next++] = line; });
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <SDL.h>
+#include <span>
+#include "fixed.h"
+
+class LumpReader;
+class ZoneArena;
+
+// Blocks are 128 map units square.
+static constexpr int map_block_shift{frac_bits + 7};
+
+// Largest radius of any mobj. Mobjs are linked into the block of their
+// center, so a search for the mobjs touching an area widens it by this.
+static constexpr fixed_t max_radius{32 * frac_unit};
+
+/**
+ * Grid of the lines crossing each block of the map, loaded from the
+ * BLOCKMAP lump. The line lists of all the blocks are packed into one
+ * array and the start of each block's list is kept in another, so
+ * walking a block reads consecutive indexes instead of chasing offsets
+ * into the lump.
+ */
+class Blockmap {
+    fixed_t origin_x{};
+    fixed_t origin_y{};
+    int width{0};
+    int height{0};
+    // Lines of block b are block_lines[block_starts[b], block_starts[b + 1]).
+    std::span<Uint32> block_starts{};
+    std::span<Uint32> block_lines{};
+
+  public:
+    // Empty blockmap, with no blocks.
+    Blockmap() = default;
+
+    Blockmap(ZoneArena& arena, LumpReader reader, size_t num_lines);
+
+    [[nodiscard]]
+    fixed_t getOriginX() const {
+        return origin_x;
+    }
+
+    [[nodiscard]]
+    fixed_t getOriginY() const {
+        return origin_y;
+    }
+
+    [[nodiscard]]
+    int getWidth() const {
+        return width;
+    }
+
+    [[nodiscard]]
+    int getHeight() const {
+        return height;
+    }
+
+    [[nodiscard]]
+    int blockX(const fixed_t x) const {
+        return (x - origin_x) >> map_block_shift;
+    }
+
+    [[nodiscard]]
+    int blockY(const fixed_t y) const {
+        return (y - origin_y) >> map_block_shift;
+    }
+
+    [[nodiscard]]
+    bool contains(const int x, const int y) const {
+        return x >= 0 && y >= 0 && x < width && y < height;
+    }
+
+    // Index of a block inside the map.
+    [[nodiscard]]
+    int blockIndex(const int x, const int y) const {
+        return y * width + x;
+    }
+
+    [[nodiscard]]
+    int numBlocks() const {
+        return width * height;
+    }
+
+    // Lines crossing a block inside the map.
+    [[nodiscard]]
+    std::span<const Uint32> linesIn(const int x, const int y) const {
+        const auto block{blockIndex(x, y)};
+        const auto start{block_starts[block]};
+        return block_lines.subspan(start, block_starts[block + 1] - start);
+    }
+};
@@ -0,0 +1,337 @@
+#include "collision.h"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include "level.h"
+#include "mobj.h"
+
+// Highest step a mobj can climb, and deepest drop a monster walks off.
+static constexpr fixed_t max_step{24 * frac_unit};
+
+// Longest move in one tic. Moves longer than half of it are split, so
+// that thin walls are not skipped over.
+static constexpr fixed_t max_move{30 * frac_unit};
+
+// Lines of a block whose bounding boxes are compared in one batch.
+static constexpr size_t line_batch{64};
+
+
+// Mobj whose position is being checked, and the box it would cover.
+struct Mover {
+    Level& level;
+    const Mobj& mobj;
+    fixed_t x;
+    fixed_t y;
+    BoundingBox box;
+};
+
+// Side of the line the point is on, 0 for the front.
+static int pointOnLineSide(
+    const fixed_t x,
+    const fixed_t y,
+    const CollisionLines& lines,
+    const size_t line
+) {
+    const auto line_x{lines.x[line]};
+    const auto line_y{lines.y[line]};
+    const auto line_dx{lines.dx[line]};
+    const auto line_dy{lines.dy[line]};
+    if (line_dx == 0) {
+        return x <= line_x ? line_dy > 0 : line_dy < 0;
+    }
+    if (line_dy == 0) {
+        return y <= line_y ? line_dx < 0 : line_dx > 0;
+    }
+    const auto left{fixedMul(line_dy >> frac_bits, x - line_x)};
+    const auto right{fixedMul(y - line_y, line_dx >> frac_bits)};
+    return right < left ? 0 : 1;
+}
+
+// Side of the line the box is on, or -1 if the line crosses it.
+static int boxOnLineSide(
+    const BoundingBox& box,
+    const CollisionLines& lines,
+    const size_t line
+) {
+    const auto line_dx{lines.dx[line]};
+    const auto line_dy{lines.dy[line]};
+    int front{};
+    int back{};
+    if (line_dy == 0) {
+        front = box[box_top] > lines.y[line];
+        back = box[box_bottom] > lines.y[line];
+        if (line_dx < 0) {
+            front ^= 1;
+            back ^= 1;
+        }
+    } else if (line_dx == 0) {
+        front = box[box_right] < lines.x[line];
+        back = box[box_left] < lines.x[line];
+        if (line_dy < 0) {
+            front ^= 1;
+            back ^= 1;
+        }
+    } else if ((line_dx ^ line_dy) >= 0) {
+        front = pointOnLineSide(box[box_left], box[box_top], lines, line);
+        back = pointOnLineSide(box[box_right], box[box_bottom], lines, line);
+    } else {
+        front = pointOnLineSide(box[box_right], box[box_top], lines, line);
+        back = pointOnLineSide(box[box_left], box[box_bottom], lines, line);
+    }
+    return front == back ? front : -1;
+}
+
+static bool checkMobj(
+    const Mover& mover,
+    Mobj& other,
+    PositionCheck& check
+) {
+    if ((other.flags & (mf_solid | mf_special | mf_shootable)) == 0) {
+        return true;
+    }
+    const auto block_dist{other.radius + mover.mobj.radius};
+    if (std::abs(other.x - mover.x) >= block_dist
+        || std::abs(other.y - mover.y) >= block_dist
+        || &other == &mover.mobj) {
+        return true;
+    }
+
+    if (mover.mobj.flags & mf_missile) {
+        // Missiles fly over and under mobjs, and not into their shooter.
+        if (mover.mobj.z > other.z + other.height
+            || mover.mobj.z + mover.mobj.height < other.z
+            || mover.level.getMobj(mover.mobj.target) == &other) {
+            return true;
+        }
+        if ((other.flags & mf_shootable) == 0) {
+            return (other.flags & mf_solid) == 0;
+        }
+        check.blocking_mobj = &other;
+        return false;
+    }
+    if ((other.flags & mf_solid) == 0) {
+        return true;
+    }
+    check.blocking_mobj = &other;
+    return false;
+}
+
+// Check the mobjs around the mover, from the level's grid if it has one
+// or from the blocks.
+static bool checkMobjs(const Mover& mover, PositionCheck& check) {
+    if (const auto grid{mover.level.getMobjGrid()}) {
+        const auto range{mover.mobj.radius};
+        return grid->checkNear(mover.x, mover.y, range, [&](Mobj& other) {
+            return checkMobj(mover, other, check);
+        });
+    }
+
+    // Mobjs are linked by their center, so the blocks of mobjs that can
+    // touch the box reach out by the largest radius.
+    const auto& box{mover.box};
+    const auto& blockmap{mover.level.getBlockmap()};
+    const auto left{blockmap.blockX(box[box_left] - max_radius)};
+    const auto right{blockmap.blockX(box[box_right] + max_radius)};
+    const auto bottom{blockmap.blockY(box[box_bottom] - max_radius)};
+    const auto top{blockmap.blockY(box[box_top] + max_radius)};
+    for (auto block_x{left}; block_x <= right; block_x++) {
+        for (auto block_y{bottom}; block_y <= top; block_y++) {
+            if (!blockmap.contains(block_x, block_y)) {
+                continue;
+            }
+            for (auto other{mover.level.firstMobjIn(block_x, block_y)}; other;
+                 other = other->block_next) {
+                if (!checkMobj(mover, *other, check)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Whether the line lets the mover through, narrowing the opening it
+// would stand in if it touches the line.
+static bool checkLine(
+    const Mover& mover,
+    const Uint32 index,
+    PositionCheck& check
+) {
+    const auto& lines{mover.level.getCollisionLines()};
+    if (boxOnLineSide(mover.box, lines, index) != -1) {
+        return true;
+    }
+    const auto& line{mover.level.getLine(index)};
+    if (!line.back_sector) {
+        return false;
+    }
+    if ((mover.mobj.flags & mf_missile) == 0
+        && (line.flags & (ml_blocking | ml_block_monsters))) {
+        return false;
+    }
+
+    const auto& front{*line.front_sector};
+    const auto& back{*line.back_sector};
+    const auto top{std::min(front.ceiling_height, back.ceiling_height)};
+    const auto bottom{std::max(front.floor_height, back.floor_height)};
+    const auto low{std::min(front.floor_height, back.floor_height)};
+    check.ceiling_z = std::min(check.ceiling_z, top);
+    check.floor_z = std::max(check.floor_z, bottom);
+    check.dropoff_z = std::min(check.dropoff_z, low);
+    return true;
+}
+
+// Check the lines of a block that no earlier block of the same check had.
+// Their bounding boxes are compared against the mover's in batches, and
+// only the lines that overlap it are checked further.
+static bool checkBlockLines(
+    const Mover& mover,
+    const std::span<const Uint32> block_lines,
+    const Uint32 stamp,
+    PositionCheck& check
+) {
+    const auto& lines{mover.level.getCollisionLines()};
+    const auto stamps{mover.level.getLineStamps()};
+    const auto& box{mover.box};
+    std::array<Uint32, line_batch> overlapping{};
+    for (size_t start = 0; start < block_lines.size(); start += line_batch) {
+        const auto count{std::min(line_batch, block_lines.size() - start)};
+        size_t num_overlapping{0};
+        for (const auto line : block_lines.subspan(start, count)) {
+            if (stamps[line] == stamp) {
+                continue;
+            }
+            stamps[line] = stamp;
+            overlapping[num_overlapping] = line;
+            num_overlapping += box[box_right] > lines.left[line]
+                               && box[box_left] < lines.right[line]
+                               && box[box_top] > lines.bottom[line]
+                               && box[box_bottom] < lines.top[line];
+        }
+        for (size_t i = 0; i < num_overlapping; i++) {
+            if (!checkLine(mover, overlapping[i], check)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool checkPosition(
+    Level& level,
+    const Mobj& mobj,
+    const fixed_t x,
+    const fixed_t y,
+    PositionCheck& check
+) {
+    check.blocking_mobj = nullptr;
+    const auto subsector{level.pointInSubsector(x, y)};
+    if (!subsector) {
+        check.floor_z = mobj.floor_z;
+        check.ceiling_z = mobj.ceiling_z;
+        check.dropoff_z = mobj.floor_z;
+        return true;
+    }
+    check.floor_z = subsector->sector->floor_height;
+    check.ceiling_z = subsector->sector->ceiling_height;
+    check.dropoff_z = subsector->sector->floor_height;
+    if (mobj.flags & mf_no_clip) {
+        return true;
+    }
+
+    Mover mover{.level = level, .mobj = mobj, .x = x, .y = y, .box = {}};
+    mover.box[box_top] = y + mobj.radius;
+    mover.box[box_bottom] = y - mobj.radius;
+    mover.box[box_left] = x - mobj.radius;
+    mover.box[box_right] = x + mobj.radius;
+    const auto& box{mover.box};
+    const auto& blockmap{level.getBlockmap()};
+
+    if (!checkMobjs(mover, check)) {
+        return false;
+    }
+
+    const auto stamp{level.newValidCount()};
+    const auto line_left{blockmap.blockX(box[box_left])};
+    const auto line_right{blockmap.blockX(box[box_right])};
+    const auto line_bottom{blockmap.blockY(box[box_bottom])};
+    const auto line_top{blockmap.blockY(box[box_top])};
+    for (auto block_x{line_left}; block_x <= line_right; block_x++) {
+        for (auto block_y{line_bottom}; block_y <= line_top; block_y++) {
+            if (!blockmap.contains(block_x, block_y)) {
+                continue;
+            }
+            const auto block_lines{blockmap.linesIn(block_x, block_y)};
+            if (!checkBlockLines(mover, block_lines, stamp, check)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool tryMove(Level& level, Mobj& mobj, const fixed_t x, const fixed_t y) {
+    PositionCheck check{};
+    if (!checkPosition(level, mobj, x, y, check)) {
+        return false;
+    }
+    if ((mobj.flags & mf_no_clip) == 0) {
+        if (check.ceiling_z - check.floor_z < mobj.height) {
+            return false;
+        }
+        const auto teleport{(mobj.flags & mf_teleport) != 0};
+        if (!teleport && check.ceiling_z - mobj.z < mobj.height) {
+            return false;
+        }
+        if (!teleport && check.floor_z - mobj.z > max_step) {
+            return false;
+        }
+        if ((mobj.flags & (mf_dropoff | mf_float)) == 0
+            && check.floor_z - check.dropoff_z > max_step) {
+            return false;
+        }
+    }
+
+    level.unlinkMobj(mobj);
+    mobj.floor_z = check.floor_z;
+    mobj.ceiling_z = check.ceiling_z;
+    mobj.x = x;
+    mobj.y = y;
+    level.linkMobj(mobj);
+    return true;
+}
+
+bool moveByMomentum(Level& level, Mobj& mobj) {
+    mobj.mom_x = std::clamp(mobj.mom_x, -max_move, max_move);
+    mobj.mom_y = std::clamp(mobj.mom_y, -max_move, max_move);
+
+    // As in the original, only moves to the right and up are split.
+    auto move_x{mobj.mom_x};
+    auto move_y{mobj.mom_y};
+    do {
+        fixed_t try_x{};
+        fixed_t try_y{};
+        if (move_x > max_move / 2 || move_y > max_move / 2) {
+            try_x = mobj.x + move_x / 2;
+            try_y = mobj.y + move_y / 2;
+            move_x >>= 1;
+            move_y >>= 1;
+        } else {
+            try_x = mobj.x + move_x;
+            try_y = mobj.y + move_y;
+            move_x = 0;
+            move_y = 0;
+        }
+        if (!tryMove(level, mobj, try_x, try_y)) {
+            if (mobj.flags & mf_missile) {
+                level.removeMobj(mobj);
+                return false;
+            }
+            mobj.mom_x = 0;
+            mobj.mom_y = 0;
+        }
+    } while (move_x != 0 || move_y != 0);
+
+    applyFriction(mobj);
+    return true;
+}
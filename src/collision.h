@@ -0,0 +1,38 @@
+#pragma once
+
+#include "fixed.h"
+
+class Level;
+struct Mobj;
+
+// Heights a mobj would stand between at a position, taking in the
+// sector there and every line it would touch.
+struct PositionCheck {
+    fixed_t floor_z{};
+    fixed_t ceiling_z{};
+    // Lowest floor the mobj would hang over, which keeps monsters from
+    // walking off ledges.
+    fixed_t dropoff_z{};
+    // Mobj that blocked the position, if a mobj did.
+    Mobj* blocking_mobj{nullptr};
+};
+
+// Whether the mobj would fit at (x, y) without running into a mobj or a
+// blocking line, as far as the blockmap tells. Heights are only filled
+// into the check, not compared to the mobj's.
+bool checkPosition(
+    Level& level,
+    const Mobj& mobj,
+    fixed_t x,
+    fixed_t y,
+    PositionCheck& check
+);
+
+// Move the mobj to (x, y) if it fits there and can step up or down to
+// the floor there, returning whether it moved.
+bool tryMove(Level& level, Mobj& mobj, fixed_t x, fixed_t y);
+
+// Move the mobj by its momentum, in steps short enough not to skip over
+// lines, then slow it down by friction. Returns false if the mobj was
+// removed: missiles are removed when something blocks them.
+bool moveByMomentum(Level& level, Mobj& mobj);
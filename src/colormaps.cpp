@@ -0,0 +1,181 @@
+#include "colormaps.h"
+#include "wad.h"
+#include "workers.h"
+#include <algorithm>
+#include <atomic>
+#include <format>
+#include <fstream>
+#include <limits>
+
+using std::domain_error;
+using std::span;
+using std::filesystem::path;
+
+// Identifies a translucency cache file, and the version of its layout.
+static constexpr char cache_magic[4]{'T', 'R', 'A', 'N'};
+static constexpr Uint32 cache_version{1};
+
+static constexpr int palette_size{256 * 3};
+
+// Every table fits in one chunk of the static zone, with room to align
+// each of the three arrays.
+static constexpr size_t tables_size{
+    sizeof(Colormap) * num_colormaps
+    + sizeof(TranslucencyTable) * num_translucency_levels
+    + sizeof(LitPalette) * num_colormaps
+    + 3 * alignof(TranslucencyTable)
+};
+
+
+// FNV-1a hash of the palette the tables are generated from.
+static Uint64 hashPalette(const span<const Uint8> palette) {
+    Uint64 hash{0xcbf29ce484222325};
+    for (const auto byte : palette) {
+        hash ^= byte;
+        hash *= 0x100000001b3;
+    }
+    for (const auto level : translucency_levels) {
+        hash ^= static_cast<Uint64>(level);
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+// Index of the palette color closest to the given one.
+static Uint8 nearestColor(
+    const span<const Uint8> palette,
+    const int r,
+    const int g,
+    const int b
+) {
+    int best{};
+    int best_distance{std::numeric_limits<int>::max()};
+    for (int i = 0; i < 256; i++) {
+        const auto dr{palette[i * 3] - r};
+        const auto dg{palette[i * 3 + 1] - g};
+        const auto db{palette[i * 3 + 2] - b};
+        const auto distance{dr * dr + dg * dg + db * db};
+        if (distance < best_distance) {
+            best = i;
+            best_distance = distance;
+            if (distance == 0) {
+                break;
+            }
+        }
+    }
+    return static_cast<Uint8>(best);
+}
+
+ColorTables::ColorTables(
+    WadManager& wad_manager,
+    WorkerGroup& workers,
+    const path& cache_file
+)
+    : arena{wad_manager.getZone(), ZoneTag::Static, tables_size}
+    , colormaps{arena.allocateArray<Colormap>(num_colormaps)}
+    , translucency{
+            arena.allocateArray<TranslucencyTable>(num_translucency_levels)
+        }
+    , lit_palettes{arena.allocateArray<LitPalette>(num_colormaps)} {
+    const auto colormap_lump{wad_manager.getLumpData("COLORMAP")};
+    if (colormap_lump.size() < sizeof(Colormap) * num_colormaps) {
+        throw domain_error{"COLORMAP lump is too small"};
+    }
+    for (int i = 0; i < num_colormaps; i++) {
+        const auto colors{colormap_lump.begin() + i * sizeof(Colormap)};
+        std::copy_n(colors, sizeof(Colormap), colormaps[i].colors);
+    }
+
+    const auto playpal{wad_manager.getLumpData("PLAYPAL")};
+    if (playpal.size() < palette_size) {
+        throw domain_error{"PLAYPAL lump is too small"};
+    }
+    // Only the first palette is used: the others are tinted for pain,
+    // item pickups and the radiation suit.
+    const span<const Uint8> palette{playpal.data(), palette_size};
+    generateLitPalettes(palette);
+    const auto key{hashPalette(palette)};
+    if (!loadCache(cache_file, key)) {
+        generateTranslucency(palette, workers);
+        saveCache(cache_file, key);
+    }
+}
+
+void ColorTables::generateTranslucency(
+    const span<const Uint8> palette,
+    WorkerGroup& workers
+) {
+    // Every (table, background) row is independent, hand them out to
+    // the workers one at a time.
+    constexpr int num_rows{num_translucency_levels * 256};
+    std::atomic<int> next_row{0};
+    workers.run([&](size_t) {
+        for (auto row{next_row++}; row < num_rows; row = next_row++) {
+            const auto level{row / 256};
+            const auto background{row % 256};
+            const auto alpha{translucency_levels[level]};
+            const auto bg{&palette[background * 3]};
+            auto colors{&translucency[level].colors[background << 8]};
+            for (int foreground = 0; foreground < 256; foreground++) {
+                const auto fg{&palette[foreground * 3]};
+                const auto r{(fg[0] * alpha + bg[0] * (100 - alpha)) / 100};
+                const auto g{(fg[1] * alpha + bg[1] * (100 - alpha)) / 100};
+                const auto b{(fg[2] * alpha + bg[2] * (100 - alpha)) / 100};
+                colors[foreground] = nearestColor(palette, r, g, b);
+            }
+        }
+    });
+}
+
+void ColorTables::generateLitPalettes(const span<const Uint8> palette) {
+    const auto argb{[palette](const int color, const int brightness) {
+        const auto r{palette[color * 3] * brightness / num_light_levels};
+        const auto g{palette[color * 3 + 1] * brightness / num_light_levels};
+        const auto b{palette[color * 3 + 2] * brightness / num_light_levels};
+        return Uint32{0xff000000} | (r << 16) | (g << 8) | b;
+    }};
+    for (int level = 0; level < num_light_levels; level++) {
+        for (int color = 0; color < 256; color++) {
+            const auto brightness{num_light_levels - level};
+            lit_palettes[level].colors[color] = argb(color, brightness);
+        }
+    }
+    // The special colormaps remap colors rather than darken them.
+    for (auto level = num_light_levels; level < num_colormaps; level++) {
+        for (int color = 0; color < 256; color++) {
+            const auto mapped{colormaps[level].colors[color]};
+            lit_palettes[level].colors[color] = argb(mapped, num_light_levels);
+        }
+    }
+}
+
+bool ColorTables::loadCache(const path& cache_file, const Uint64 key) {
+    std::ifstream cache{cache_file, std::ios::binary};
+    char magic[sizeof(cache_magic)]{};
+    Uint32 version{};
+    Uint64 cache_key{};
+    cache.read(magic, sizeof(magic));
+    cache.read((char*) &version, sizeof(version));
+    cache.read((char*) &cache_key, sizeof(cache_key));
+    if (!cache
+        || !std::equal(std::begin(magic), std::end(magic), cache_magic)
+        || version != cache_version
+        || cache_key != key) {
+        return false;
+    }
+    for (auto& table : translucency) {
+        cache.read((char*) table.colors, sizeof(table.colors));
+    }
+    return static_cast<bool>(cache);
+}
+
+void ColorTables::saveCache(const path& cache_file, const Uint64 key) const {
+    // The cache is only an optimization, failing to write it is fine.
+    std::ofstream cache{cache_file, std::ios::binary};
+    cache.write(cache_magic, sizeof(cache_magic));
+    cache.write((const char*) &cache_version, sizeof(cache_version));
+    cache.write((const char*) &key, sizeof(key));
+    for (const auto& table : translucency) {
+        cache.write((const char*) table.colors, sizeof(table.colors));
+    }
+}
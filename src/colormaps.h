@@ -0,0 +1,87 @@
+#pragma once
+
+#include <SDL.h>
+#include <filesystem>
+#include <iterator>
+#include <span>
+#include "zone.h"
+
+class WadManager;
+class WorkerGroup;
+
+// Light levels of COLORMAP, from the brightest to the darkest. The
+// lump holds two more maps: the invulnerability effect and all black.
+static constexpr int num_light_levels{32};
+static constexpr int invulnerability_colormap{32};
+static constexpr int num_colormaps{34};
+
+// Opacity of the foreground in each translucency table, in percent.
+static constexpr int translucency_levels[]{25, 50, 75};
+static constexpr int num_translucency_levels{std::size(translucency_levels)};
+
+// Maps one palette index to another, e.g. to darken it.
+struct alignas(64) Colormap {
+    Uint8 colors[256];
+};
+
+// ARGB8888 colors of the palette at one light level, for drawing in
+// true color without going through a colormap.
+struct alignas(64) LitPalette {
+    Uint32 colors[256];
+};
+
+/**
+ * Blends a foreground color over a background color, looked up as
+ * colors[(background << 8) | foreground]. Drawing keeps the background
+ * of a row of pixels mostly constant, so lookups stay within the same
+ * 256 byte row, which is four cache lines.
+ */
+struct alignas(64) TranslucencyTable {
+    Uint8 colors[256 * 256];
+};
+
+/**
+ * Lighting and translucency lookup tables. The colormaps come from the
+ * COLORMAP lump, and the pre-lit palettes used in true color scale the
+ * PLAYPAL colors directly, which gives smoother shading. The translucency
+ * tables are generated from PLAYPAL, which takes a while, so they are
+ * cached on disk and only rebuilt when the palette changes. The tables
+ * are kept in the static zone.
+ */
+class ColorTables {
+    ZoneArena arena;
+    std::span<Colormap> colormaps;
+    std::span<TranslucencyTable> translucency;
+    std::span<LitPalette> lit_palettes;
+
+    bool loadCache(const std::filesystem::path& cache_file, Uint64 key);
+    void saveCache(const std::filesystem::path& cache_file, Uint64 key) const;
+    void generateTranslucency(
+        std::span<const Uint8> palette,
+        WorkerGroup& workers
+    );
+    void generateLitPalettes(std::span<const Uint8> palette);
+
+  public:
+    ColorTables(
+        WadManager& wad_manager,
+        WorkerGroup& workers,
+        const std::filesystem::path& cache_file
+    );
+
+    [[nodiscard]]
+    const Uint8* getColormap(const int colormap) const {
+        return colormaps[colormap].colors;
+    }
+
+    [[nodiscard]]
+    const Uint32* getLitPalette(const int colormap) const {
+        return lit_palettes[colormap].colors;
+    }
+
+    // Table for the given index in translucency_levels.
+    [[nodiscard]]
+    const Uint8* getTranslucency(const int level) const {
+        return translucency[level].colors;
+    }
+};
@@ -0,0 +1,154 @@
+#include "compress.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using std::domain_error;
+using std::span;
+using std::vector;
+
+static constexpr size_t min_match{4};
+static constexpr size_t max_offset{0xffff};
+
+// Lengths up to this fit in the token, longer ones continue after it.
+static constexpr size_t token_length{15};
+
+static constexpr int hash_bits{14};
+
+
+static Uint32 read32(const Uint8* data) {
+    Uint32 value{};
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static Uint32 hash32(const Uint32 value) {
+    return (value * 2654435761U) >> (32 - hash_bits);
+}
+
+static void writeLength(vector<Uint8>& out, size_t length) {
+    while (length >= 255) {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back(static_cast<Uint8>(length));
+}
+
+static void writeSequence(
+    vector<Uint8>& out,
+    const span<const Uint8> literals,
+    const size_t offset,
+    const size_t match_length
+) {
+    const auto literal_code{std::min(literals.size(), token_length)};
+    const auto match_code{
+        match_length ? std::min(match_length - min_match, token_length) : 0
+    };
+    out.push_back(static_cast<Uint8>(literal_code << 4 | match_code));
+    if (literal_code == token_length) {
+        writeLength(out, literals.size() - token_length);
+    }
+    out.insert(out.end(), literals.begin(), literals.end());
+    if (match_length == 0) {
+        return;
+    }
+    out.push_back(static_cast<Uint8>(offset));
+    out.push_back(static_cast<Uint8>(offset >> 8));
+    if (match_code == token_length) {
+        writeLength(out, match_length - min_match - token_length);
+    }
+}
+
+void compress(const span<const Uint8> data, vector<Uint8>& compressed) {
+    compressed.clear();
+    vector<Sint32> table(size_t{1} << hash_bits, -1);
+    size_t anchor{0};
+    size_t pos{0};
+    while (pos + min_match <= data.size()) {
+        const auto value{read32(&data[pos])};
+        auto& entry{table[hash32(value)]};
+        const auto candidate{entry};
+        entry = static_cast<Sint32>(pos);
+        if (candidate < 0 || pos - candidate > max_offset
+            || read32(&data[candidate]) != value) {
+            pos++;
+            continue;
+        }
+        auto length{min_match};
+        while (pos + length < data.size()
+               && data[candidate + length] == data[pos + length]) {
+            length++;
+        }
+        const auto literals{data.subspan(anchor, pos - anchor)};
+        writeSequence(compressed, literals, pos - candidate, length);
+        pos += length;
+        anchor = pos;
+    }
+    // The last sequence is only literals, possibly none.
+    writeSequence(compressed, data.subspan(anchor), 0, 0);
+}
+
+static size_t readLength(
+    const span<const Uint8> in,
+    size_t& pos,
+    size_t length
+) {
+    Uint8 byte{};
+    do {
+        if (pos >= in.size()) {
+            throw domain_error{"Compressed data is truncated"};
+        }
+        byte = in[pos++];
+        length += byte;
+    } while (byte == 255);
+    return length;
+}
+
+void decompress(
+    const span<const Uint8> compressed,
+    const size_t size,
+    vector<Uint8>& data
+) {
+    data.resize(size);
+    size_t in{0};
+    size_t out{0};
+    while (in < compressed.size()) {
+        const auto token{compressed[in++]};
+        auto literals{static_cast<size_t>(token >> 4)};
+        if (literals == token_length) {
+            literals = readLength(compressed, in, literals);
+        }
+        if (literals > compressed.size() - in || literals > size - out) {
+            throw domain_error{"Compressed data is corrupt"};
+        }
+        std::copy_n(compressed.begin() + in, literals, data.begin() + out);
+        in += literals;
+        out += literals;
+        if (in == compressed.size()) {
+            break;
+        }
+
+        if (compressed.size() - in < 2) {
+            throw domain_error{"Compressed data is truncated"};
+        }
+        const auto offset{
+            static_cast<size_t>(compressed[in] | compressed[in + 1] << 8)
+        };
+        in += 2;
+        auto length{static_cast<size_t>(token & 0xf)};
+        if (length == token_length) {
+            length = readLength(compressed, in, length);
+        }
+        length += min_match;
+        if (offset == 0 || offset > out || length > size - out) {
+            throw domain_error{"Compressed data is corrupt"};
+        }
+        // Copies can overlap their own output, to repeat short runs.
+        for (size_t i = 0; i < length; i++, out++) {
+            data[out] = data[out - offset];
+        }
+    }
+    if (out != size) {
+        throw domain_error{"Compressed data is truncated"};
+    }
+}
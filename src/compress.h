@@ -0,0 +1,20 @@
+#pragma once
+
+#include <SDL.h>
+#include <span>
+#include <vector>
+
+/**
+ * Byte-oriented LZ77 compression in the style of LZ4: sequences of
+ * literal bytes, each followed by a copy of earlier output. It trades
+ * ratio for speed, compressing and decompressing at hundreds of MB/s,
+ * which suits game states that are saved in the middle of play.
+ */
+void compress(std::span<const Uint8> data, std::vector<Uint8>& compressed);
+
+// Decompress data that is known to expand to size bytes.
+void decompress(
+    std::span<const Uint8> compressed,
+    size_t size,
+    std::vector<Uint8>& data
+);
@@ -0,0 +1,218 @@
+#include "demo.h"
+#include "lump.h"
+#include "wad.h"
+#include <format>
+#include <string>
+
+using std::domain_error;
+using std::span;
+using std::vector;
+
+// Demos recorded by version 1.4 and later start with the version number.
+// Earlier ones start with the skill, which is never larger than 4.
+static constexpr int first_versioned_demo{104};
+
+// Marks the end of the commands in a demo.
+static constexpr Uint8 demo_end_marker{0x80};
+
+// Identifies the state hashes following the end marker.
+static constexpr char hashes_magic[4]{'H', 'A', 'S', 'H'};
+
+// Bytes of buffered commands written to the file at once.
+static constexpr size_t record_buffer_size{4096};
+
+
+static GameSettings readSettings(LumpReader& reader, int& version) {
+    GameSettings settings{};
+    const auto first_byte{reader.readByte()};
+    if (first_byte >= first_versioned_demo) {
+        version = first_byte;
+        settings.skill = reader.readByte();
+    } else {
+        version = 0;
+        settings.skill = first_byte;
+    }
+    settings.episode = reader.readByte();
+    settings.map = reader.readByte();
+    if (version != 0) {
+        settings.deathmatch = reader.readByte() != 0;
+        settings.respawn = reader.readByte() != 0;
+        settings.fast = reader.readByte() != 0;
+        settings.no_monsters = reader.readByte() != 0;
+        settings.console_player = reader.readByte();
+    } else {
+        settings.console_player = 0;
+    }
+    for (auto& in_game : settings.player_in_game) {
+        in_game = reader.readByte() != 0;
+    }
+    if (settings.console_player >= max_players) {
+        throw domain_error{"Demo has an invalid console player"};
+    }
+    return settings;
+}
+
+static vector<Uint64> readStateHashes(LumpReader& reader) {
+    constexpr auto header_size{sizeof(hashes_magic) + 2 * sizeof(Uint32)};
+    if (reader.size() - reader.tell() < header_size) {
+        return {};
+    }
+    const auto magic{reader.readSpan(sizeof(hashes_magic))};
+    if (!std::equal(magic.begin(), magic.end(), hashes_magic)) {
+        return {};
+    }
+    const auto interval{static_cast<Uint32>(reader.readInt())};
+    const auto count{static_cast<Uint32>(reader.readInt())};
+    // A trailer cut short is ignored like a missing one, before the
+    // count is trusted with an allocation.
+    const auto hashes_size{static_cast<size_t>(count) * sizeof(Uint64)};
+    if (interval != state_hash_interval
+        || reader.size() - reader.tell() < hashes_size) {
+        return {};
+    }
+    vector<Uint64> hashes(count);
+    for (auto& hash : hashes) {
+        const auto low{static_cast<Uint32>(reader.readInt())};
+        const auto high{static_cast<Uint32>(reader.readInt())};
+        hash = (Uint64{high} << 32) | low;
+    }
+    return hashes;
+}
+
+Demo::Demo(const span<const Uint8> data) {
+    LumpReader reader{data};
+    settings = readSettings(reader, version);
+    num_players = settings.numPlayers();
+    if (num_players == 0) {
+        throw domain_error{"Demo has no players"};
+    }
+
+    // Demos cut short without an end marker are played up to the last
+    // complete tic.
+    const auto tic_size{static_cast<size_t>(num_players) * 4};
+    while (reader.tell() < reader.size()) {
+        if (data[reader.tell()] == demo_end_marker) {
+            reader.readByte();
+            state_hashes = readStateHashes(reader);
+            break;
+        }
+        if (reader.size() - reader.tell() < tic_size) {
+            break;
+        }
+        for (int player = 0; player < num_players; player++) {
+            TicCmd cmd{};
+            cmd.forward_move = static_cast<Sint8>(reader.readByte());
+            cmd.side_move = static_cast<Sint8>(reader.readByte());
+            cmd.angle_turn = static_cast<Sint16>(reader.readByte() << 8);
+            cmd.buttons = reader.readByte();
+            commands.push_back(cmd);
+        }
+    }
+}
+
+Demo Demo::load(WadManager& wad_manager, const std::string_view name) {
+    std::string lump_name{name};
+    for (auto& c : lump_name) {
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    if (wad_manager.hasLump(lump_name)) {
+        const auto lump_index{wad_manager.getLumpIndex(lump_name)};
+        return Demo{wad_manager.cacheLumpData(lump_index)};
+    }
+    std::ifstream file{std::filesystem::path{name}, std::ios::binary};
+    if (!file) {
+        const auto error{std::format("Demo \"{}\" not found", name)};
+        throw domain_error{error};
+    }
+    const vector<Uint8> data{
+        std::istreambuf_iterator<char>{file},
+        std::istreambuf_iterator<char>{}
+    };
+    return Demo{data};
+}
+
+
+DemoRecorder::DemoRecorder(
+    const std::filesystem::path& path,
+    const GameSettings& settings
+)
+    : file{path, std::ios::binary} {
+    if (!file) {
+        const auto error{
+            std::format("Could not create demo \"{}\"", path.string())
+        };
+        throw domain_error{error};
+    }
+    buffer.reserve(record_buffer_size);
+    buffer.push_back(demo_version);
+    buffer.push_back(static_cast<Uint8>(settings.skill));
+    buffer.push_back(static_cast<Uint8>(settings.episode));
+    buffer.push_back(static_cast<Uint8>(settings.map));
+    buffer.push_back(settings.deathmatch);
+    buffer.push_back(settings.respawn);
+    buffer.push_back(settings.fast);
+    buffer.push_back(settings.no_monsters);
+    buffer.push_back(static_cast<Uint8>(settings.console_player));
+    for (const auto in_game : settings.player_in_game) {
+        buffer.push_back(in_game);
+    }
+}
+
+DemoRecorder::~DemoRecorder() {
+    LumpWriter writer{buffer};
+    writer.writeByte(demo_end_marker);
+    writer.write({reinterpret_cast<const Uint8*>(hashes_magic), 4});
+    writer.writeInt(state_hash_interval);
+    writer.writeInt(static_cast<Sint32>(state_hashes.size()));
+    for (const auto hash : state_hashes) {
+        writer.writeInt(static_cast<Sint32>(hash));
+        writer.writeInt(static_cast<Sint32>(hash >> 32));
+    }
+    flush();
+}
+
+void DemoRecorder::flush() {
+    file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    buffer.clear();
+}
+
+void DemoRecorder::record(const span<TicCmd> commands) {
+    for (auto& cmd : commands) {
+        const auto angle_turn{static_cast<Uint8>((cmd.angle_turn + 128) >> 8)};
+        cmd.angle_turn = static_cast<Sint16>(angle_turn << 8);
+        buffer.push_back(static_cast<Uint8>(cmd.forward_move));
+        buffer.push_back(static_cast<Uint8>(cmd.side_move));
+        buffer.push_back(angle_turn);
+        buffer.push_back(cmd.buttons);
+    }
+    if (buffer.size() >= record_buffer_size) {
+        flush();
+    }
+}
+
+void DemoRecorder::recordState(const Game& game) {
+    if (game.getTic() % state_hash_interval == 0) {
+        state_hashes.push_back(game.hash());
+    }
+}
+
+
+bool DesyncDetector::check(const Game& game) {
+    if (desync_tic) {
+        return false;
+    }
+    const auto tic{game.getTic()};
+    if (tic % state_hash_interval != 0) {
+        return true;
+    }
+    const auto index{tic / state_hash_interval - 1};
+    if (index >= state_hashes.size()) {
+        return true;
+    }
+    if (game.hash() != state_hashes[index]) {
+        // The state was last known good one interval earlier.
+        desync_tic = tic - state_hash_interval;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <SDL.h>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "game.h"
+
+class WadManager;
+
+// Version number written in the header of recorded demos, that of the
+// final release.
+static constexpr int demo_version{109};
+
+// Tics between the game state hashes stored with recorded demos.
+static constexpr Uint32 state_hash_interval{tic_rate};
+
+/**
+ * A demo in the vanilla .lmp format: a header with the game settings,
+ * followed by one TicCmd per player in game for every tic, until the
+ * end marker.
+ *
+ * Demos recorded here also store hashes of the game state after the end
+ * marker, where vanilla stops reading, to detect desyncs on playback.
+ */
+class Demo {
+    int version{};
+    GameSettings settings{};
+    int num_players{};
+    std::vector<TicCmd> commands{};
+    std::vector<Uint64> state_hashes{};
+
+  public:
+    explicit Demo(std::span<const Uint8> data);
+
+    // Load the demo from a lump, or from a file if no lump has that name.
+    // Safe to call from several threads.
+    [[nodiscard]]
+    static Demo load(WadManager& wad_manager, std::string_view name);
+
+    [[nodiscard]]
+    int getVersion() const {
+        return version;
+    }
+
+    [[nodiscard]]
+    const GameSettings& getSettings() const {
+        return settings;
+    }
+
+    [[nodiscard]]
+    size_t getNumTics() const {
+        return commands.size() / num_players;
+    }
+
+    // Commands of the players in game during the given tic.
+    [[nodiscard]]
+    std::span<const TicCmd> getTic(const size_t tic) const {
+        return {&commands[tic * num_players], static_cast<size_t>(num_players)};
+    }
+
+    // Hash of the game state after every state_hash_interval tics, if
+    // the demo has them.
+    [[nodiscard]]
+    std::span<const Uint64> getStateHashes() const {
+        return state_hashes;
+    }
+};
+
+/**
+ * Records the commands of a game into a demo file. Commands are packed
+ * into a small buffer that is written out whenever it fills up, so long
+ * recordings do not grow in memory. The demo is finished when the
+ * recorder is destroyed.
+ */
+class DemoRecorder {
+    std::ofstream file;
+    std::vector<Uint8> buffer{};
+    std::vector<Uint64> state_hashes{};
+
+    void flush();
+
+  public:
+    DemoRecorder(
+        const std::filesystem::path& path,
+        const GameSettings& settings
+    );
+    DemoRecorder(DemoRecorder& other) = delete;
+    ~DemoRecorder();
+    DemoRecorder& operator=(const DemoRecorder& other) = delete;
+
+    /**
+     * Record the commands of one tic. Demos store the turn angle with
+     * less precision, so the commands are rounded the same way, to play
+     * the game exactly as it will play back.
+     */
+    void record(std::span<TicCmd> commands);
+
+    // Record the state of the game after a tic.
+    void recordState(const Game& game);
+};
+
+/**
+ * Compares the state of a game playing back a demo with the hashes
+ * stored in it, and remembers the first tic they differ.
+ */
+class DesyncDetector {
+    std::span<const Uint64> state_hashes;
+    std::optional<Uint32> desync_tic{};
+
+  public:
+    explicit DesyncDetector(const Demo& demo)
+        : state_hashes{demo.getStateHashes()} {
+    }
+
+    // Check the state of the game after a tic. Returns false once the
+    // game desynced.
+    bool check(const Game& game);
+
+    // Last tic the game was known to be in sync, when it desynced within
+    // the following state_hash_interval tics.
+    [[nodiscard]]
+    std::optional<Uint32> getDesyncTic() const {
+        return desync_tic;
+    }
+};
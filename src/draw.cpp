@@ -0,0 +1,300 @@
+#include "draw.h"
+#include <type_traits>
+#include <utility>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define DRAW_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define DRAW_SSE2
+#endif
+
+// Row pitches that get a dedicated drawer: integer multiples of the
+// native width plus the widths of the usual 16:9 modes.
+using SpecializedPitches = std::integer_sequence<
+    int, 320, 428, 640, 852, 960, 1280, 1600, 1920, 2560, 3200, 3840
+>;
+
+using Layout = FrameLayout;
+
+// Masks selecting the flat row and column from the span position.
+static constexpr Uint32 flat_row_mask{63 * 64};
+static constexpr Uint32 flat_column_mask{63};
+
+
+// Color of a texel at the light level of the column or span.
+template <typename Pixel, typename Draw>
+static Pixel shade(const Draw& draw, const Uint8 texel) {
+    if constexpr (std::is_same_v<Pixel, Uint32>) {
+        return draw.lit_palette[texel];
+    } else {
+        return draw.colormap[texel];
+    }
+}
+
+// Distance between vertically adjacent pixels.
+template <Layout L, int Pitch>
+static constexpr int rowStride(const FrameBuffer& frame) {
+    if constexpr (L == Layout::ColumnMajor) {
+        return 1;
+    } else if constexpr (Pitch == 0) {
+        return frame.pitch;
+    } else {
+        return Pitch;
+    }
+}
+
+// Distance between horizontally adjacent pixels.
+template <Layout L, int Pitch>
+static constexpr int columnStride(const FrameBuffer& frame) {
+    if constexpr (L == Layout::RowMajor) {
+        return 1;
+    } else if constexpr (Pitch == 0) {
+        return frame.pitch;
+    } else {
+        return Pitch;
+    }
+}
+
+template <typename Pixel, Layout L, int Pitch>
+static void drawColumn(
+    const FrameBuffer& frame,
+    const int center_y,
+    const ColumnDraw& column
+) {
+    auto count{column.yh - column.yl};
+    if (count < 0) {
+        return;
+    }
+    const auto stride{rowStride<L, Pitch>(frame)};
+    auto dest{frame.at<Pixel>(column.x, column.yl)};
+    const auto step{column.iscale};
+    auto frac{column.texture_mid + (column.yl - center_y) * step};
+
+    // Texture columns are 128 texels high, taller walls repeat.
+    do {
+        *dest = shade<Pixel>(column, column.source[(frac >> frac_bits) & 127]);
+        dest += stride;
+        frac += step;
+    } while (count--);
+}
+
+template <typename Pixel, Layout L, int Pitch>
+static void drawSpan(const FrameBuffer& frame, const SpanDraw& span) {
+    auto count{span.x2 - span.x1};
+    if (count < 0) {
+        return;
+    }
+    const auto stride{columnStride<L, Pitch>(frame)};
+    auto dest{frame.at<Pixel>(span.x1, span.y)};
+    auto x_frac{span.x_frac};
+    auto y_frac{span.y_frac};
+
+    // Flats are 64x64 texels, stored row by row.
+    do {
+        const auto spot{
+            ((y_frac >> (frac_bits - 6)) & flat_row_mask)
+            + ((x_frac >> frac_bits) & flat_column_mask)
+        };
+        *dest = shade<Pixel>(span, span.source[spot]);
+        dest += stride;
+        x_frac += span.x_step;
+        y_frac += span.y_step;
+    } while (count--);
+}
+
+#if defined(DRAW_AVX2) || defined(DRAW_SSE2)
+#ifdef DRAW_AVX2
+using SpanVector = __m256i;
+static constexpr int vector_lanes{8};
+
+static SpanVector spanLanes(const Uint32 frac, const Uint32 step) {
+    return _mm256_setr_epi32(
+        frac, frac + step, frac + 2 * step, frac + 3 * step,
+        frac + 4 * step, frac + 5 * step, frac + 6 * step, frac + 7 * step
+    );
+}
+
+static void storeSpots(const SpanVector x, const SpanVector y, Uint32* spots) {
+    const auto row_mask{_mm256_set1_epi32(flat_row_mask)};
+    const auto column_mask{_mm256_set1_epi32(flat_column_mask)};
+    const auto row{
+        _mm256_and_si256(_mm256_srli_epi32(y, frac_bits - 6), row_mask)
+    };
+    const auto column{
+        _mm256_and_si256(_mm256_srli_epi32(x, frac_bits), column_mask)
+    };
+    const auto spot{_mm256_or_si256(row, column)};
+    _mm256_store_si256(reinterpret_cast<__m256i*>(spots), spot);
+}
+
+static SpanVector addLanes(const SpanVector a, const SpanVector b) {
+    return _mm256_add_epi32(a, b);
+}
+
+static SpanVector broadcast(const Uint32 value) {
+    return _mm256_set1_epi32(static_cast<int>(value));
+}
+#else
+using SpanVector = __m128i;
+static constexpr int vector_lanes{4};
+
+static SpanVector spanLanes(const Uint32 frac, const Uint32 step) {
+    return _mm_setr_epi32(frac, frac + step, frac + 2 * step, frac + 3 * step);
+}
+
+static void storeSpots(const SpanVector x, const SpanVector y, Uint32* spots) {
+    const auto row_mask{_mm_set1_epi32(flat_row_mask)};
+    const auto column_mask{_mm_set1_epi32(flat_column_mask)};
+    const auto row{_mm_and_si128(_mm_srli_epi32(y, frac_bits - 6), row_mask)};
+    const auto column{_mm_and_si128(_mm_srli_epi32(x, frac_bits), column_mask)};
+    const auto spot{_mm_or_si128(row, column)};
+    _mm_store_si128(reinterpret_cast<__m128i*>(spots), spot);
+}
+
+static SpanVector addLanes(const SpanVector a, const SpanVector b) {
+    return _mm_add_epi32(a, b);
+}
+
+static SpanVector broadcast(const Uint32 value) {
+    return _mm_set1_epi32(static_cast<int>(value));
+}
+#endif
+
+// Pixels drawn per iteration: two vectors, to hide the latency of the
+// stepping behind the texel lookups.
+static constexpr int span_block{2 * vector_lanes};
+
+/**
+ * Same output as drawSpan, but the flat coordinates of a whole block of
+ * pixels are stepped and turned into texel offsets in vector registers.
+ * Flats and colormaps are byte tables, which no x86 gather instruction
+ * can read without overrunning them, so the lookups stay scalar.
+ */
+template <typename Pixel, Layout L, int Pitch>
+static void drawSpanVector(const FrameBuffer& frame, const SpanDraw& span) {
+    const auto count{span.x2 - span.x1 + 1};
+    if (count <= 0) {
+        return;
+    }
+    const auto stride{columnStride<L, Pitch>(frame)};
+    auto dest{frame.at<Pixel>(span.x1, span.y)};
+
+    // Unsigned, so that positions wrap around like the 32-bit lanes do.
+    auto x_frac{static_cast<Uint32>(span.x_frac)};
+    auto y_frac{static_cast<Uint32>(span.y_frac)};
+    const auto x_step{static_cast<Uint32>(span.x_step)};
+    const auto y_step{static_cast<Uint32>(span.y_step)};
+
+    const auto blocks{count / span_block};
+    if (blocks > 0) {
+        const auto lane_step{static_cast<Uint32>(vector_lanes)};
+        SpanVector x[2]{
+            spanLanes(x_frac, x_step),
+            spanLanes(x_frac + lane_step * x_step, x_step),
+        };
+        SpanVector y[2]{
+            spanLanes(y_frac, y_step),
+            spanLanes(y_frac + lane_step * y_step, y_step),
+        };
+        const auto block_step{static_cast<Uint32>(span_block)};
+        const auto x_block_step{broadcast(block_step * x_step)};
+        const auto y_block_step{broadcast(block_step * y_step)};
+        alignas(32) Uint32 spots[span_block];
+
+        for (int block = 0; block < blocks; block++) {
+            storeSpots(x[0], y[0], spots);
+            storeSpots(x[1], y[1], spots + vector_lanes);
+            for (int i = 0; i < 2; i++) {
+                x[i] = addLanes(x[i], x_block_step);
+                y[i] = addLanes(y[i], y_block_step);
+            }
+            for (const auto spot : spots) {
+                *dest = shade<Pixel>(span, span.source[spot]);
+                dest += stride;
+            }
+        }
+        const auto drawn{static_cast<Uint32>(blocks * span_block)};
+        x_frac += drawn * x_step;
+        y_frac += drawn * y_step;
+    }
+
+    for (auto i = blocks * span_block; i < count; i++) {
+        const auto spot{
+            ((y_frac >> (frac_bits - 6)) & flat_row_mask)
+            + ((x_frac >> frac_bits) & flat_column_mask)
+        };
+        *dest = shade<Pixel>(span, span.source[spot]);
+        dest += stride;
+        x_frac += x_step;
+        y_frac += y_step;
+    }
+}
+
+#define DRAW_SPAN drawSpanVector
+#else
+#define DRAW_SPAN drawSpan
+#endif
+
+template <typename Pixel, int... Pitches>
+static auto selectColumnFunc(
+    const FrameBuffer& frame,
+    std::integer_sequence<int, Pitches...>
+) {
+    // Columns of a column-major buffer are contiguous whatever the
+    // pitch, so only the row-major drawers are specialized.
+    if (frame.layout == Layout::ColumnMajor) {
+        return &drawColumn<Pixel, Layout::ColumnMajor, 0>;
+    }
+    auto func{&drawColumn<Pixel, Layout::RowMajor, 0>};
+    const auto pitch{frame.pitch};
+    ((pitch == Pitches
+      && (func = &drawColumn<Pixel, Layout::RowMajor, Pitches>))
+     || ...);
+    return func;
+}
+
+template <typename Pixel, int... Pitches>
+static auto selectSpanFunc(
+    const FrameBuffer& frame,
+    std::integer_sequence<int, Pitches...>
+) {
+    if (frame.layout == Layout::ColumnMajor) {
+        return &DRAW_SPAN<Pixel, Layout::ColumnMajor, 0>;
+    }
+    auto func{&DRAW_SPAN<Pixel, Layout::RowMajor, 0>};
+    const auto pitch{frame.pitch};
+    ((pitch == Pitches
+      && (func = &DRAW_SPAN<Pixel, Layout::RowMajor, Pitches>))
+     || ...);
+    return func;
+}
+
+Drawer::Drawer(const FrameBuffer& frame)
+    : frame{frame}
+    , center_y{frame.height / 2} {
+    constexpr SpecializedPitches pitches{};
+    if (frame.true_color) {
+        column_func = selectColumnFunc<Uint32>(frame, pitches);
+        span_func = selectSpanFunc<Uint32>(frame, pitches);
+    } else {
+        column_func = selectColumnFunc<Uint8>(frame, pitches);
+        span_func = selectSpanFunc<Uint8>(frame, pitches);
+    }
+}
+
+void drawSpanScalar(const FrameBuffer& frame, const SpanDraw& span) {
+    const auto column_major{frame.layout == Layout::ColumnMajor};
+    if (frame.true_color) {
+        if (column_major) {
+            drawSpan<Uint32, Layout::ColumnMajor, 0>(frame, span);
+        } else {
+            drawSpan<Uint32, Layout::RowMajor, 0>(frame, span);
+        }
+    } else if (column_major) {
+        drawSpan<Uint8, Layout::ColumnMajor, 0>(frame, span);
+    } else {
+        drawSpan<Uint8, Layout::RowMajor, 0>(frame, span);
+    }
+}
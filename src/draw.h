@@ -0,0 +1,83 @@
+#pragma once
+
+#include "fixed.h"
+#include "video.h"
+
+/**
+ * A vertical run of pixels taken from a texture column, used for
+ * walls and sprites.
+ */
+struct ColumnDraw {
+    // Screen column, and first and last rows to draw (inclusive).
+    int x;
+    int yl;
+    int yh;
+
+    // Texture step per screen row, and texture row at the view center.
+    fixed_t iscale;
+    fixed_t texture_mid;
+
+    // Texture column (128 texels high), and colormap or pre-lit palette
+    // of the light level, the latter when drawing in true color.
+    const Uint8* source;
+    const Uint8* colormap;
+    const Uint32* lit_palette;
+};
+
+/**
+ * A horizontal run of pixels taken from a 64x64 flat, used for
+ * floors and ceilings.
+ */
+struct SpanDraw {
+    // Screen row, and first and last columns to draw (inclusive).
+    int y;
+    int x1;
+    int x2;
+
+    // Flat position of the first pixel, and step per screen column.
+    fixed_t x_frac;
+    fixed_t y_frac;
+    fixed_t x_step;
+    fixed_t y_step;
+
+    const Uint8* source;
+    const Uint8* colormap;
+    const Uint32* lit_palette;
+};
+
+/**
+ * Low level pixel writers of the renderer. The drawers are templates
+ * over the pixel type, and the framebuffer layout and pitch: common
+ * render widths get a specialization with the row stride folded into
+ * the code, and any other width falls back to a stride read at run time.
+ */
+class Drawer {
+    using ColumnFunc = void (*)(const FrameBuffer&, int, const ColumnDraw&);
+    using SpanFunc = void (*)(const FrameBuffer&, const SpanDraw&);
+
+    FrameBuffer frame;
+    int center_y;
+    ColumnFunc column_func;
+    SpanFunc span_func;
+
+  public:
+    explicit Drawer(const FrameBuffer& frame);
+
+    // Row at which a column's texture_mid is sampled.
+    [[nodiscard]]
+    int getCenterY() const {
+        return center_y;
+    }
+
+    void drawColumn(const ColumnDraw& column) const {
+        column_func(frame, center_y, column);
+    }
+
+    void drawSpan(const SpanDraw& span) const {
+        span_func(frame, span);
+    }
+};
+
+// Draw a span with the plain scalar drawer, even where Drawer uses the
+// vectorized one, so that the two can be compared.
+void drawSpanScalar(const FrameBuffer& frame, const SpanDraw& span);
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <SDL.h>
+#include <limits>
+
+// 16.16 fixed point number, the numeric type used throughout Doom's
+// renderer and game logic.
+using fixed_t = Sint32;
+
+static constexpr int frac_bits{16};
+static constexpr fixed_t frac_unit{1 << frac_bits};
+
+static constexpr fixed_t fixed_max{std::numeric_limits<fixed_t>::max()};
+static constexpr fixed_t fixed_min{std::numeric_limits<fixed_t>::min()};
+
+constexpr fixed_t fixedMul(const fixed_t a, const fixed_t b) {
+    return static_cast<fixed_t>((static_cast<Sint64>(a) * b) >> frac_bits);
+}
+
+// Quotient of a and b, saturated when it does not fit, as the original
+// checked before dividing.
+constexpr fixed_t fixedDiv(const fixed_t a, const fixed_t b) {
+    const auto abs_a{a < 0 ? -static_cast<Sint64>(a) : a};
+    const auto abs_b{b < 0 ? -static_cast<Sint64>(b) : b};
+    if ((abs_a >> 14) >= abs_b) {
+        return (a ^ b) < 0 ? fixed_min : fixed_max;
+    }
+    return static_cast<fixed_t>((static_cast<Sint64>(a) << frac_bits) / b);
+}
@@ -0,0 +1,145 @@
+#include "game.h"
+#include "level.h"
+#include "lump.h"
+#include <algorithm>
+
+using std::span;
+
+// Movement is scaled from the command to a thrust.
+static constexpr fixed_t move_scale{2048};
+
+static constexpr fixed_t max_move{30 * frac_unit};
+
+
+int GameSettings::numPlayers() const {
+    return static_cast<int>(
+        std::count(player_in_game.begin(), player_in_game.end(), true)
+    );
+}
+
+Game::Game(const GameSettings& settings)
+    : settings{settings}
+    , level{std::make_unique<Level>()} {
+    for (auto& player : players) {
+        player.health = 100;
+        player.ammo = 50;
+    }
+}
+
+Game::Game(const GameSettings& settings, WadManager& wad_manager)
+    : Game{settings} {
+    level = std::make_unique<Level>(wad_manager, settings);
+    for (int i = 0; i < max_players; i++) {
+        const auto& start{level->getPlayerStart(i)};
+        if (!start) {
+            continue;
+        }
+        auto& player{players[i]};
+        player.x = start->x;
+        player.y = start->y;
+        player.angle = start->angle;
+        if (const auto subsector{level->pointInSubsector(start->x, start->y)}) {
+            player.z = subsector->sector->floor_height;
+        }
+    }
+}
+
+Game::Game(Game&& other) noexcept = default;
+
+Game::~Game() = default;
+
+static void thrust(Player& player, const angle_t angle, const fixed_t move) {
+    player.mom_x += fixedMul(move, fineCosine(angle));
+    player.mom_y += fixedMul(move, fineSine(angle));
+}
+
+void Game::movePlayer(Player& player, const TicCmd& cmd) {
+    player.angle += static_cast<angle_t>(cmd.angle_turn) << 16;
+    if (cmd.forward_move) {
+        thrust(player, player.angle, cmd.forward_move * move_scale);
+    }
+    if (cmd.side_move) {
+        thrust(player, player.angle - ang90, cmd.side_move * move_scale);
+    }
+
+    player.mom_x = std::clamp(player.mom_x, -max_move, max_move);
+    player.mom_y = std::clamp(player.mom_y, -max_move, max_move);
+    player.x += player.mom_x;
+    player.y += player.mom_y;
+
+    // Players without input stop dead once slow enough, instead of
+    // sliding forever.
+    const auto idle{cmd.forward_move == 0 && cmd.side_move == 0};
+    if (idle && std::abs(player.mom_x) < stop_speed
+        && std::abs(player.mom_y) < stop_speed) {
+        player.mom_x = 0;
+        player.mom_y = 0;
+        return;
+    }
+    player.mom_x = fixedMul(player.mom_x, friction);
+    player.mom_y = fixedMul(player.mom_y, friction);
+}
+
+void Game::ticker(const span<const TicCmd> commands) {
+    auto command{commands.begin()};
+    for (int i = 0; i < max_players; i++) {
+        if (!settings.player_in_game[i] || command == commands.end()) {
+            continue;
+        }
+        movePlayer(players[i], *command++);
+    }
+    level->runThinkers();
+    game_tic++;
+}
+
+void Game::writeState(std::vector<Uint8>& state) const {
+    state.clear();
+    LumpWriter writer{state};
+    writer.writeInt(static_cast<Sint32>(game_tic));
+    for (const auto& player : players) {
+        writer.writeInt(player.x);
+        writer.writeInt(player.y);
+        writer.writeInt(player.z);
+        writer.writeInt(static_cast<Sint32>(player.angle));
+        writer.writeInt(player.mom_x);
+        writer.writeInt(player.mom_y);
+        writer.writeInt(player.health);
+        writer.writeInt(player.armor);
+        writer.writeInt(player.ammo);
+    }
+    level->writeState(writer);
+}
+
+void Game::readState(const span<const Uint8> state) {
+    // Nothing changes until the whole state was read, so that a state
+    // that cannot be read leaves the game as it was.
+    LumpReader reader{state};
+    const auto tic{static_cast<Uint32>(reader.readInt())};
+    auto read_players{players};
+    for (auto& player : read_players) {
+        player.x = reader.readInt();
+        player.y = reader.readInt();
+        player.z = reader.readInt();
+        player.angle = static_cast<angle_t>(reader.readInt());
+        player.mom_x = reader.readInt();
+        player.mom_y = reader.readInt();
+        player.health = reader.readInt();
+        player.armor = reader.readInt();
+        player.ammo = reader.readInt();
+    }
+    level->readState(reader);
+    game_tic = tic;
+    players = read_players;
+}
+
+Uint64 Game::hash() const {
+    // FNV-1a of the serialized state, which has no padding to hash.
+    std::vector<Uint8> state{};
+    writeState(state);
+    Uint64 value{0xcbf29ce484222325};
+    for (const auto byte : state) {
+        value ^= byte;
+        value *= 0x100000001b3;
+    }
+    return value;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <SDL.h>
+#include <array>
+#include <memory>
+#include <span>
+#include <vector>
+#include "fixed.h"
+#include "tables.h"
+
+class Level;
+class WadManager;
+
+static constexpr int max_players{4};
+
+// Game tics per second.
+static constexpr int tic_rate{35};
+
+/**
+ * Movement and actions of one player during one tic, as the game
+ * receives them from input devices or a demo.
+ */
+struct TicCmd {
+    Sint8 forward_move;
+    Sint8 side_move;
+    Sint16 angle_turn;
+    Uint8 buttons;
+};
+
+// Bits of TicCmd::buttons.
+static constexpr Uint8 button_attack{1};
+static constexpr Uint8 button_use{2};
+
+/**
+ * Options a game is started with, which demos record in their header.
+ */
+struct GameSettings {
+    int skill{2};
+    int episode{1};
+    int map{1};
+    bool deathmatch{false};
+    bool respawn{false};
+    bool fast{false};
+    bool no_monsters{false};
+    int console_player{0};
+    std::array<bool, max_players> player_in_game{true, false, false, false};
+
+    [[nodiscard]]
+    int numPlayers() const;
+};
+
+struct Player {
+    fixed_t x;
+    fixed_t y;
+    fixed_t z;
+    angle_t angle;
+    fixed_t mom_x;
+    fixed_t mom_y;
+    int health;
+    int armor;
+    int ammo;
+};
+
+/**
+ * State of a game, advanced one tic at a time by the commands of the
+ * players in it. The simulation is deterministic: the same settings and
+ * commands always lead to the same state, which is what keeps demos in
+ * sync.
+ */
+class Game {
+    GameSettings settings;
+    std::unique_ptr<Level> level;
+    std::array<Player, max_players> players{};
+    Uint32 game_tic{0};
+
+    void movePlayer(Player& player, const TicCmd& cmd);
+
+  public:
+    // Game on an empty level.
+    explicit Game(const GameSettings& settings);
+
+    // Game on the map the settings start on.
+    Game(const GameSettings& settings, WadManager& wad_manager);
+
+    Game(Game&& other) noexcept;
+    ~Game();
+
+    [[nodiscard]]
+    const GameSettings& getSettings() const {
+        return settings;
+    }
+
+    [[nodiscard]]
+    Uint32 getTic() const {
+        return game_tic;
+    }
+
+    [[nodiscard]]
+    const Player& getConsolePlayer() const {
+        return players[settings.console_player];
+    }
+
+    [[nodiscard]]
+    Level& getLevel() const {
+        return *level;
+    }
+
+    // Run one tic, with one command per player in game, in player order.
+    void ticker(std::span<const TicCmd> commands);
+
+    // Serialized game state, without the settings, which can only be
+    // read back into a game with the same settings.
+    void writeState(std::vector<Uint8>& state) const;
+
+    void readState(std::span<const Uint8> state);
+
+    // Hash of the whole game state, to detect demo desyncs.
+    [[nodiscard]]
+    Uint64 hash() const;
+};
@@ -0,0 +1,273 @@
+#include "hud.h"
+#include "colormaps.h"
+#include "lump.h"
+#include "wad.h"
+#include <algorithm>
+#include <cstring>
+#include <format>
+
+using std::span;
+using std::vector;
+
+// Top of the status bar, in HUD coordinates.
+static constexpr int status_bar_y{168};
+static constexpr int status_bar_height{native_height - status_bar_y};
+
+// Width of the large status bar digits.
+static constexpr int digit_width{14};
+
+// Patches end their columns with this top delta.
+static constexpr Uint8 end_of_column{0xff};
+
+
+static bool intersects(const SDL_Rect& a, const SDL_Rect& b) {
+    return a.x < b.x + b.w && b.x < a.x + a.w
+        && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+static SDL_Rect intersect(const SDL_Rect& a, const SDL_Rect& b) {
+    const auto x1{std::max(a.x, b.x)};
+    const auto y1{std::max(a.y, b.y)};
+    const auto x2{std::min(a.x + a.w, b.x + b.w)};
+    const auto y2{std::min(a.y + a.h, b.y + b.h)};
+    return {x1, y1, std::max(x2 - x1, 0), std::max(y2 - y1, 0)};
+}
+
+static SDL_Rect merge(const SDL_Rect& a, const SDL_Rect& b) {
+    const auto x1{std::min(a.x, b.x)};
+    const auto y1{std::min(a.y, b.y)};
+    const auto x2{std::max(a.x + a.w, b.x + b.w)};
+    const auto y2{std::max(a.y + a.h, b.y + b.h)};
+    return {x1, y1, x2 - x1, y2 - y1};
+}
+
+void DirtyRegions::add(const SDL_Rect& region) {
+    if (region.w <= 0 || region.h <= 0) {
+        return;
+    }
+    // A merged region may now overlap regions it did not before, so keep
+    // merging until it overlaps none.
+    auto merged{region};
+    for (auto i{regions.begin()}; i != regions.end();) {
+        if (intersects(merged, *i)) {
+            merged = merge(merged, *i);
+            regions.erase(i);
+            i = regions.begin();
+        } else {
+            ++i;
+        }
+    }
+    regions.push_back(merged);
+}
+
+
+HudScale::HudScale(const FrameBuffer& frame) {
+    const auto scale_x{(frame.width << frac_bits) / native_width};
+    const auto scale_y{(frame.height << frac_bits) / native_height};
+    scale = std::min(scale_x, scale_y);
+    inverse = static_cast<fixed_t>((Sint64{1} << (2 * frac_bits)) / scale);
+    // Offsets are measured from an unshifted mapping.
+    origin_x = 0;
+    origin_y = 0;
+    origin_x = (frame.width - toScreenX(native_width)) / 2;
+    origin_y = frame.height - toScreenY(native_height);
+}
+
+int HudScale::toScreenX(const int x) const {
+    return origin_x + static_cast<int>((Sint64{x} * scale) >> frac_bits);
+}
+
+int HudScale::toScreenY(const int y) const {
+    return origin_y + static_cast<int>((Sint64{y} * scale) >> frac_bits);
+}
+
+SDL_Rect HudScale::toScreen(const SDL_Rect& rect) const {
+    const auto x1{toScreenX(rect.x)};
+    const auto y1{toScreenY(rect.y)};
+    const auto x2{toScreenX(rect.x + rect.w)};
+    const auto y2{toScreenY(rect.y + rect.h)};
+    return {x1, y1, x2 - x1, y2 - y1};
+}
+
+
+HudPainter::HudPainter(
+    const FrameBuffer& frame,
+    const ColorTables& color_tables
+)
+    : frame{frame}
+    , drawer{frame}
+    , scale{frame}
+    , colormap{color_tables.getColormap(0)}
+    , lit_palette{color_tables.getLitPalette(0)} {
+}
+
+void HudPainter::drawPatch(
+    const int x,
+    const int y,
+    const span<const Uint8> patch
+) const {
+    LumpReader reader{patch};
+    const auto width{reader.readShort()};
+    [[maybe_unused]] const auto height{reader.readShort()};
+    const auto left{x - reader.readShort()};
+    const auto top{y - reader.readShort()};
+    vector<Sint32> column_ofs(width);
+    for (auto& ofs : column_ofs) {
+        ofs = reader.readInt();
+    }
+
+    const auto x1{std::max(scale.toScreenX(left), 0)};
+    const auto x2{std::min(scale.toScreenX(left + width), frame.width)};
+    const auto center_y{drawer.getCenterY()};
+    for (auto screen_x{x1}; screen_x < x2; screen_x++) {
+        const auto offset{screen_x - scale.toScreenX(left)};
+        const auto column{std::min(
+            static_cast<int>((Sint64{offset} * scale.inverse) >> frac_bits),
+            width - 1
+        )};
+        reader.seek(column_ofs[column]);
+        for (auto top_delta{reader.readByte()}; top_delta != end_of_column;
+             top_delta = reader.readByte()) {
+            const auto length{reader.readByte()};
+            [[maybe_unused]] const auto padding{reader.readByte()};
+            const auto texels{reader.readSpan(length)};
+            [[maybe_unused]] const auto post_padding{reader.readByte()};
+
+            // Clip the post so that the last row never steps past it.
+            const auto post_y{scale.toScreenY(top + top_delta)};
+            const auto last_texel{((length << frac_bits) - 1) / scale.inverse};
+            const auto yl{std::max(post_y, 0)};
+            const auto yh{std::min({
+                scale.toScreenY(top + top_delta + length) - 1,
+                post_y + last_texel,
+                frame.height - 1
+            })};
+            if (length == 0 || yl > yh) {
+                continue;
+            }
+            drawer.drawColumn({
+                .x = screen_x,
+                .yl = yl,
+                .yh = yh,
+                .iscale = scale.inverse,
+                .texture_mid = (center_y - post_y) * scale.inverse,
+                .source = texels.data(),
+                .colormap = colormap,
+                .lit_palette = lit_palette,
+            });
+        }
+    }
+}
+
+
+SDL_Rect NumberWidget::bounds() const {
+    const auto digits_width{num_digits * digit_width};
+    const auto percent_width{percent ? digit_width : 0};
+    return {x - digits_width, y, digits_width + percent_width, 16};
+}
+
+
+// Copies pixels between the frame and the saved status bar background.
+template <typename Pixel>
+static void copyBackground(
+    const FrameBuffer& frame,
+    Uint8* saved,
+    const SDL_Rect& area,
+    const SDL_Rect& rect,
+    const bool restore
+) {
+    auto saved_pixels{reinterpret_cast<Pixel*>(saved)};
+    for (auto y{rect.y}; y < rect.y + rect.h; y++) {
+        for (auto x{rect.x}; x < rect.x + rect.w; x++) {
+            auto& saved_pixel{
+                saved_pixels[(y - area.y) * area.w + (x - area.x)]
+            };
+            auto pixel{frame.at<Pixel>(x, y)};
+            if (restore) {
+                *pixel = saved_pixel;
+            } else {
+                saved_pixel = *pixel;
+            }
+        }
+    }
+}
+
+static void copyBackground(
+    const FrameBuffer& frame,
+    Uint8* saved,
+    const SDL_Rect& area,
+    const SDL_Rect& rect,
+    const bool restore
+) {
+    if (frame.true_color) {
+        copyBackground<Uint32>(frame, saved, area, rect, restore);
+    } else {
+        copyBackground<Uint8>(frame, saved, area, rect, restore);
+    }
+}
+
+StatusBar::StatusBar(
+    WadManager& wad_manager,
+    const FrameBuffer& frame,
+    const ColorTables& color_tables
+)
+    : background_patch{wad_manager.getLumpData("STBAR")}
+    , percent_patch{wad_manager.getLumpData("STTPRCNT")}
+    , frame{frame}
+    , painter{frame, color_tables} {
+    for (int digit = 0; digit < 10; digit++) {
+        const auto name{std::format("STTNUM{}", digit)};
+        digit_patches.emplace_back(wad_manager.getLumpData(name));
+    }
+    const auto& scale{painter.getScale()};
+    area = scale.toScreen({0, status_bar_y, native_width, status_bar_height});
+    area.x = std::max(area.x, 0);
+    area.w = std::min(area.w, frame.width - area.x);
+    area.h = std::min(area.h, frame.height - area.y);
+}
+
+void StatusBar::drawBackground(DirtyRegions& dirty) {
+    painter.drawPatch(0, status_bar_y, background_patch);
+    const auto pixel_size{frame.true_color ? sizeof(Uint32) : sizeof(Uint8)};
+    saved_background.resize(area.w * area.h * pixel_size);
+    copyBackground(frame, saved_background.data(), area, area, false);
+    dirty.add(area);
+}
+
+void StatusBar::drawWidget(
+    NumberWidget& widget,
+    const int value,
+    DirtyRegions& dirty
+) {
+    const auto clamped{std::clamp(value, 0, 999)};
+    if (widget.drawn_value == clamped) {
+        return;
+    }
+    const auto bounds{
+        intersect(painter.getScale().toScreen(widget.bounds()), area)
+    };
+    copyBackground(frame, saved_background.data(), area, bounds, true);
+
+    // Digits are drawn right to left, a zero value still shows one digit.
+    auto x{widget.x};
+    auto remaining{clamped};
+    do {
+        x -= digit_width;
+        painter.drawPatch(x, widget.y, digit_patches[remaining % 10]);
+        remaining /= 10;
+    } while (remaining > 0);
+    if (widget.percent) {
+        painter.drawPatch(widget.x, widget.y, percent_patch);
+    }
+    widget.drawn_value = clamped;
+    dirty.add(bounds);
+}
+
+void StatusBar::draw(const PlayerStatus& status, DirtyRegions& dirty) {
+    if (saved_background.empty()) {
+        drawBackground(dirty);
+    }
+    drawWidget(ammo, status.ammo, dirty);
+    drawWidget(health, status.health, dirty);
+    drawWidget(armor, status.armor, dirty);
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <SDL.h>
+#include <optional>
+#include <span>
+#include <vector>
+#include "draw.h"
+
+class ColorTables;
+class WadManager;
+
+/**
+ * Screen regions that changed since the last frame. Overlapping regions
+ * are merged, so that every pixel is uploaded at most once.
+ */
+class DirtyRegions {
+    std::vector<SDL_Rect> regions{};
+
+  public:
+    void add(const SDL_Rect& region);
+
+    void clear() {
+        regions.clear();
+    }
+
+    [[nodiscard]]
+    std::span<const SDL_Rect> get() const {
+        return regions;
+    }
+};
+
+/**
+ * Maps the 320x200 coordinates HUD graphics are laid out in to the
+ * screen. Graphics are scaled by the same factor on both axes, centered
+ * horizontally and aligned to the bottom of the screen.
+ */
+struct HudScale {
+    // Screen pixels per HUD pixel, and its inverse.
+    fixed_t scale;
+    fixed_t inverse;
+    int origin_x;
+    int origin_y;
+
+    explicit HudScale(const FrameBuffer& frame);
+
+    [[nodiscard]]
+    int toScreenX(int x) const;
+
+    [[nodiscard]]
+    int toScreenY(int y) const;
+
+    [[nodiscard]]
+    SDL_Rect toScreen(const SDL_Rect& rect) const;
+};
+
+/**
+ * Draws patches given in HUD coordinates at full brightness.
+ */
+class HudPainter {
+    FrameBuffer frame;
+    Drawer drawer;
+    HudScale scale;
+    const Uint8* colormap;
+    const Uint32* lit_palette;
+
+  public:
+    HudPainter(const FrameBuffer& frame, const ColorTables& color_tables);
+
+    [[nodiscard]]
+    const HudScale& getScale() const {
+        return scale;
+    }
+
+    void drawPatch(int x, int y, std::span<const Uint8> patch) const;
+};
+
+// Values shown in the status bar.
+struct PlayerStatus {
+    int health;
+    int armor;
+    int ammo;
+};
+
+/**
+ * Right-aligned number drawn with the large status bar digits, only
+ * redrawn when its value changes.
+ */
+struct NumberWidget {
+    // Right edge and top of the number, in HUD coordinates.
+    int x;
+    int y;
+    int num_digits;
+    bool percent;
+    std::optional<int> drawn_value{};
+
+    // Area covered by the widget, in HUD coordinates.
+    [[nodiscard]]
+    SDL_Rect bounds() const;
+};
+
+/**
+ * The status bar at the bottom of the screen. Its background is drawn
+ * once and kept, and each frame only the widgets whose value changed
+ * are erased and drawn again, and reported as dirty.
+ */
+class StatusBar {
+    std::vector<Uint8> background_patch;
+    std::vector<std::vector<Uint8>> digit_patches{};
+    std::vector<Uint8> percent_patch;
+    FrameBuffer frame;
+    HudPainter painter;
+    SDL_Rect area;
+
+    // Copy of the status bar background, in the frame's pixel format,
+    // used to erase widgets before drawing them again.
+    std::vector<Uint8> saved_background{};
+
+    NumberWidget ammo{44, 171, 3, false};
+    NumberWidget health{90, 171, 3, true};
+    NumberWidget armor{221, 171, 3, true};
+
+    void drawBackground(DirtyRegions& dirty);
+    void drawWidget(NumberWidget& widget, int value, DirtyRegions& dirty);
+
+  public:
+    StatusBar(
+        WadManager& wad_manager,
+        const FrameBuffer& frame,
+        const ColorTables& color_tables
+    );
+
+    // Area of the screen taken by the status bar.
+    [[nodiscard]]
+    const SDL_Rect& getArea() const {
+        return area;
+    }
+
+    void draw(const PlayerStatus& status, DirtyRegions& dirty);
+};
@@ -0,0 +1,58 @@
+#include "input.h"
+#include <SDL.h>
+
+// Speeds for walking and running.
+static constexpr Sint8 forward_move[2]{25, 50};
+static constexpr Sint8 side_move[2]{24, 40};
+static constexpr Sint16 angle_turn[2]{640, 1280};
+
+
+TicCmd buildTicCmd() {
+    const auto keys{SDL_GetKeyboardState(nullptr)};
+    const auto speed{
+        keys[SDL_SCANCODE_LSHIFT] || keys[SDL_SCANCODE_RSHIFT] ? 1 : 0
+    };
+    const auto strafe{keys[SDL_SCANCODE_LALT] || keys[SDL_SCANCODE_RALT]};
+
+    int forward{0};
+    int side{0};
+    int turn{0};
+    if (keys[SDL_SCANCODE_UP]) {
+        forward += forward_move[speed];
+    }
+    if (keys[SDL_SCANCODE_DOWN]) {
+        forward -= forward_move[speed];
+    }
+    if (keys[SDL_SCANCODE_RIGHT]) {
+        if (strafe) {
+            side += side_move[speed];
+        } else {
+            turn -= angle_turn[speed];
+        }
+    }
+    if (keys[SDL_SCANCODE_LEFT]) {
+        if (strafe) {
+            side -= side_move[speed];
+        } else {
+            turn += angle_turn[speed];
+        }
+    }
+    if (keys[SDL_SCANCODE_PERIOD]) {
+        side += side_move[speed];
+    }
+    if (keys[SDL_SCANCODE_COMMA]) {
+        side -= side_move[speed];
+    }
+
+    TicCmd cmd{};
+    cmd.forward_move = static_cast<Sint8>(forward);
+    cmd.side_move = static_cast<Sint8>(side);
+    cmd.angle_turn = static_cast<Sint16>(turn);
+    if (keys[SDL_SCANCODE_LCTRL] || keys[SDL_SCANCODE_RCTRL]) {
+        cmd.buttons |= button_attack;
+    }
+    if (keys[SDL_SCANCODE_SPACE]) {
+        cmd.buttons |= button_use;
+    }
+    return cmd;
+}
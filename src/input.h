@@ -0,0 +1,10 @@
+#pragma once
+
+#include "game.h"
+
+/**
+ * Build the command of the local player for the next tic from the
+ * current keyboard state: arrows move and turn, Alt strafes, comma and
+ * period strafe, Shift runs, Ctrl fires and Space uses.
+ */
+TicCmd buildTicCmd();
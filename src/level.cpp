@@ -0,0 +1,801 @@
+#include "level.h"
+#include "collision.h"
+#include "lump.h"
+#include "wad.h"
+#include <algorithm>
+#include <format>
+#include <vector>
+
+using std::domain_error;
+using std::string;
+
+// Offsets of the lumps of a map from its marker lump.
+enum MapLump {
+    map_things = 1,
+    map_linedefs,
+    map_sidedefs,
+    map_vertexes,
+    map_segs,
+    map_ssectors,
+    map_nodes,
+    map_sectors,
+    map_reject,
+    map_blockmap,
+};
+
+// Size and flags of each mobj until there is a table of mobj types.
+static constexpr fixed_t default_radius{20 * frac_unit};
+static constexpr fixed_t default_height{16 * frac_unit};
+static constexpr Uint32 default_flags{mf_solid | mf_shootable};
+
+// Thing options.
+static constexpr int thing_easy{1};
+static constexpr int thing_normal{2};
+static constexpr int thing_hard{4};
+static constexpr int thing_multiplayer{16};
+
+static constexpr int deathmatch_start{11};
+
+// Ends the thinkers in a saved state.
+static constexpr Uint8 end_of_thinkers{0xff};
+
+// Bytes of a sector, line and side in a saved state, and of the fields
+// of a mobj between its slot and its sector.
+static constexpr size_t saved_sector_size{30};
+static constexpr size_t saved_line_size{6};
+static constexpr size_t saved_side_size{32};
+static constexpr size_t saved_mobj_fields_size{15 * 4};
+
+// Most mobj slots a saved state can have, far more than any level uses,
+// so that a corrupt count is not trusted with an allocation.
+static constexpr Uint32 max_saved_slots{1 << 20};
+
+static constexpr Uint16 no_side{0xffff};
+
+// Sight checks remembered during a tic.
+static constexpr size_t sight_cache_size{4096};
+
+
+static TextureName readTextureName(LumpReader& reader) {
+    TextureName name{};
+    reader.read(reinterpret_cast<Uint8*>(name.data()), name.size());
+    return name;
+}
+
+static fixed_t readFixed(LumpReader& reader) {
+    return reader.readShort() * frac_unit;
+}
+
+static Uint16 readIndex(LumpReader& reader, const size_t count) {
+    const auto index{static_cast<Uint16>(reader.readShort())};
+    if (static_cast<size_t>(index) >= count) {
+        throw domain_error{"Map refers to a missing element"};
+    }
+    return index;
+}
+
+// Array for the elements of a lump, each of the given size on disk.
+template <typename T>
+static std::span<T> allocate(
+    ZoneArena& arena,
+    const LumpReader& reader,
+    const size_t size
+) {
+    return arena.allocateArray<T>(reader.size() / size);
+}
+
+void Level::loadVertexes(LumpReader reader) {
+    vertexes = allocate<Vertex>(*arena, reader, 4);
+    for (auto& vertex : vertexes) {
+        vertex.x = readFixed(reader);
+        vertex.y = readFixed(reader);
+    }
+}
+
+void Level::loadSectors(LumpReader reader) {
+    sectors = allocate<Sector>(*arena, reader, 26);
+    for (auto& sector : sectors) {
+        sector.floor_height = readFixed(reader);
+        sector.ceiling_height = readFixed(reader);
+        sector.floor_pic = readTextureName(reader);
+        sector.ceiling_pic = readTextureName(reader);
+        sector.light_level = reader.readShort();
+        sector.special = reader.readShort();
+        sector.tag = reader.readShort();
+    }
+}
+
+void Level::loadSides(LumpReader reader) {
+    sides = allocate<Side>(*arena, reader, 30);
+    for (auto& side : sides) {
+        side.texture_offset = readFixed(reader);
+        side.row_offset = readFixed(reader);
+        side.top_texture = readTextureName(reader);
+        side.bottom_texture = readTextureName(reader);
+        side.mid_texture = readTextureName(reader);
+        side.sector = &sectors[readIndex(reader, sectors.size())];
+    }
+}
+
+void Level::loadLines(LumpReader reader) {
+    lines = allocate<Line>(*arena, reader, 14);
+    for (auto& line : lines) {
+        line.v1 = &vertexes[readIndex(reader, vertexes.size())];
+        line.v2 = &vertexes[readIndex(reader, vertexes.size())];
+        line.flags = reader.readShort();
+        line.special = reader.readShort();
+        line.tag = reader.readShort();
+        for (auto& side : line.sides) {
+            const auto side_num{static_cast<Uint16>(reader.readShort())};
+            if (side_num == no_side) {
+                side = nullptr;
+            } else if (side_num < sides.size()) {
+                side = &sides[side_num];
+            } else {
+                throw domain_error{"Line refers to a missing side"};
+            }
+        }
+        if (!line.sides[0]) {
+            throw domain_error{"Line has no front side"};
+        }
+        line.dx = line.v2->x - line.v1->x;
+        line.dy = line.v2->y - line.v1->y;
+        line.front_sector = line.sides[0]->sector;
+        line.back_sector = line.sides[1] ? line.sides[1]->sector : nullptr;
+        line.bbox[box_top] = std::max(line.v1->y, line.v2->y);
+        line.bbox[box_bottom] = std::min(line.v1->y, line.v2->y);
+        line.bbox[box_left] = std::min(line.v1->x, line.v2->x);
+        line.bbox[box_right] = std::max(line.v1->x, line.v2->x);
+    }
+}
+
+void Level::loadBlockmap(LumpReader reader) {
+    blockmap = Blockmap{*arena, reader, lines.size()};
+    block_mobjs = arena->allocateArray<Mobj*>(blockmap.numBlocks());
+    line_stamps = arena->allocateArray<Uint32>(lines.size());
+
+    const auto count{lines.size()};
+    const auto field{[&] { return arena->allocateArray<fixed_t>(count); }};
+    collision_lines = {
+        .left = field(),
+        .right = field(),
+        .bottom = field(),
+        .top = field(),
+        .x = field(),
+        .y = field(),
+        .dx = field(),
+        .dy = field(),
+    };
+    for (size_t i = 0; i < count; i++) {
+        const auto& line{lines[i]};
+        collision_lines.left[i] = line.bbox[box_left];
+        collision_lines.right[i] = line.bbox[box_right];
+        collision_lines.bottom[i] = line.bbox[box_bottom];
+        collision_lines.top[i] = line.bbox[box_top];
+        collision_lines.x[i] = line.v1->x;
+        collision_lines.y[i] = line.v1->y;
+        collision_lines.dx[i] = line.dx;
+        collision_lines.dy[i] = line.dy;
+    }
+}
+
+void Level::loadReject(LumpReader reader) {
+    // Short REJECT lumps, which the original read past the end of, are
+    // padded with zeros.
+    const auto bits{sectors.size() * sectors.size()};
+    reject = arena->allocateArray<Uint8>((bits + 7) / 8);
+    reader.read(reject.data(), std::min(reject.size(), reader.size()));
+    const auto entries{arena->allocateArray<SightCacheEntry>(sight_cache_size)};
+    sight_cache = SightCache{entries};
+}
+
+void Level::disableReject() {
+    std::ranges::fill(reject, Uint8{0});
+}
+
+void Level::disableSightCache() {
+    sight_cache = SightCache{};
+}
+
+void Level::linkSectors() {
+    // Every two-sided line between different sectors links them both
+    // ways. The links of each sector are sorted by the sector they lead
+    // to, and the links to the same sector merged, so that noise only
+    // goes through one link to each sector. That one blocks sound if all
+    // the lines it stands for do.
+    std::vector<std::vector<SectorLink>> links(sectors.size());
+    for (const auto& line : lines) {
+        if ((line.flags & ml_two_sided) == 0 || !line.back_sector
+            || line.front_sector == line.back_sector) {
+            continue;
+        }
+        const auto front{sectorIndex(*line.front_sector)};
+        const auto back{sectorIndex(*line.back_sector)};
+        const auto sound_block{(line.flags & ml_sound_block) != 0};
+        links[front].push_back({back, sound_block});
+        links[back].push_back({front, sound_block});
+    }
+
+    size_t count{0};
+    for (auto& sector_links : links) {
+        std::ranges::stable_sort(sector_links, {}, &SectorLink::sector);
+        auto merged{sector_links.begin()};
+        for (auto link{sector_links.begin()}; link != sector_links.end();
+             link++) {
+            if (merged != sector_links.begin()
+                && (merged - 1)->sector == link->sector) {
+                (merged - 1)->sound_block &= link->sound_block;
+            } else {
+                *merged++ = *link;
+            }
+        }
+        sector_links.erase(merged, sector_links.end());
+        count += sector_links.size();
+    }
+
+    sector_link_starts = arena->allocateArray<Uint32>(sectors.size() + 1);
+    sector_links = arena->allocateArray<SectorLink>(count);
+    Uint32 next{0};
+    for (size_t sector = 0; sector < sectors.size(); sector++) {
+        sector_link_starts[sector] = next;
+        std::ranges::copy(links[sector], sector_links.begin() + next);
+        next += static_cast<Uint32>(links[sector].size());
+    }
+    sector_link_starts[sectors.size()] = next;
+    sound_queues = arena->allocateArray<Uint32>(2 * sectors.size());
+}
+
+void Level::loadSegs(LumpReader reader) {
+    segs = allocate<Seg>(*arena, reader, 12);
+    for (auto& seg : segs) {
+        seg.v1 = &vertexes[readIndex(reader, vertexes.size())];
+        seg.v2 = &vertexes[readIndex(reader, vertexes.size())];
+        seg.angle = static_cast<angle_t>(reader.readShort()) << 16;
+        auto& line{lines[readIndex(reader, lines.size())]};
+        const auto side{reader.readShort() != 0 ? 1 : 0};
+        seg.offset = readFixed(reader);
+        if (!line.sides[side]) {
+            throw domain_error{"Seg is on a missing side"};
+        }
+        seg.line = &line;
+        seg.side = line.sides[side];
+        seg.front_sector = line.sides[side]->sector;
+        const auto back{line.sides[side ^ 1]};
+        seg.back_sector = back ? back->sector : nullptr;
+    }
+}
+
+void Level::loadSubsectors(LumpReader reader) {
+    subsectors = allocate<Subsector>(*arena, reader, 4);
+    for (auto& subsector : subsectors) {
+        subsector.num_segs = static_cast<Uint16>(reader.readShort());
+        subsector.first_seg = readIndex(reader, segs.size());
+        if (subsector.num_segs == 0
+            || static_cast<size_t>(subsector.first_seg + subsector.num_segs)
+                   > segs.size()) {
+            throw domain_error{"Subsector has invalid segs"};
+        }
+        subsector.sector = segs[subsector.first_seg].side->sector;
+    }
+}
+
+void Level::loadNodes(LumpReader reader) {
+    nodes = allocate<Node>(*arena, reader, 28);
+    for (auto& node : nodes) {
+        node.x = readFixed(reader);
+        node.y = readFixed(reader);
+        node.dx = readFixed(reader);
+        node.dy = readFixed(reader);
+        for (auto& bbox : node.bbox) {
+            for (auto& side : bbox) {
+                side = readFixed(reader);
+            }
+        }
+        for (auto& child : node.children) {
+            child = static_cast<Uint16>(reader.readShort());
+            const auto is_subsector{(child & node_subsector) != 0};
+            const auto index{static_cast<size_t>(child & ~node_subsector)};
+            const auto count{is_subsector ? subsectors.size() : nodes.size()};
+            if (index >= count) {
+                throw domain_error{"Node refers to a missing child"};
+            }
+        }
+    }
+}
+
+static int skillBit(const int skill) {
+    if (skill <= 1) {
+        return thing_easy;
+    }
+    return skill == 2 ? thing_normal : thing_hard;
+}
+
+void Level::loadThings(LumpReader reader, const GameSettings& settings) {
+    const auto count{reader.size() / 10};
+    const auto multiplayer{settings.deathmatch || settings.numPlayers() > 1};
+    for (size_t i = 0; i < count; i++) {
+        MapThing thing{};
+        thing.x = readFixed(reader);
+        thing.y = readFixed(reader);
+        thing.angle = ang45 * static_cast<angle_t>(reader.readShort() / 45);
+        thing.type = reader.readShort();
+        thing.options = reader.readShort();
+
+        if (thing.type >= 1 && thing.type <= max_players) {
+            player_starts[thing.type - 1] = thing;
+            continue;
+        }
+        if (thing.type == deathmatch_start) {
+            continue;
+        }
+        if (!multiplayer && (thing.options & thing_multiplayer)) {
+            continue;
+        }
+        if ((thing.options & skillBit(settings.skill)) == 0) {
+            continue;
+        }
+        const auto subsector{pointInSubsector(thing.x, thing.y)};
+        const auto z{subsector ? subsector->sector->floor_height : 0};
+        auto& mobj{spawnMobj(thing.x, thing.y, z, thing.type)};
+        mobj.angle = thing.angle;
+    }
+}
+
+Level::Level(WadManager& wad_manager, const GameSettings& settings)
+    : arena{std::in_place, wad_manager.getZone(), ZoneTag::Level} {
+    // The renderer's scratch memory grew to the views of the last level,
+    // so it goes back to the heap and grows again to those of this one.
+    wad_manager.getZone().purge();
+    const auto name{mapName(wad_manager, settings)};
+    const auto marker{wad_manager.getLumpIndex(name)};
+    const auto lump{[&](const MapLump map_lump) {
+        return LumpReader{wad_manager.cacheLumpData(marker + map_lump)};
+    }};
+    loadVertexes(lump(map_vertexes));
+    loadSectors(lump(map_sectors));
+    loadSides(lump(map_sidedefs));
+    loadLines(lump(map_linedefs));
+    linkSectors();
+    loadSegs(lump(map_segs));
+    loadSubsectors(lump(map_ssectors));
+    loadNodes(lump(map_nodes));
+    loadReject(lump(map_reject));
+    loadBlockmap(lump(map_blockmap));
+    loadThings(lump(map_things), settings);
+}
+
+// Side of the node's partition line the point is on, 0 for the right.
+static int pointOnSide(const fixed_t x, const fixed_t y, const Node& node) {
+    if (node.dx == 0) {
+        return x <= node.x ? node.dy > 0 : node.dy < 0;
+    }
+    if (node.dy == 0) {
+        return y <= node.y ? node.dx < 0 : node.dx > 0;
+    }
+    const auto dx{x - node.x};
+    const auto dy{y - node.y};
+
+    // Try to quickly decide by looking at the signs.
+    if ((node.dy ^ node.dx ^ dx ^ dy) & 0x80000000) {
+        return ((node.dy ^ dx) & 0x80000000) ? 1 : 0;
+    }
+    const auto left{fixedMul(node.dy >> frac_bits, dx)};
+    const auto right{fixedMul(dy, node.dx >> frac_bits)};
+    return right < left ? 0 : 1;
+}
+
+const Subsector* Level::pointInSubsector(
+    const fixed_t x,
+    const fixed_t y
+) const {
+    if (subsectors.empty()) {
+        return nullptr;
+    }
+    // A map with a single subsector has no nodes.
+    if (nodes.empty()) {
+        return &subsectors[0];
+    }
+    auto child{static_cast<Uint16>(nodes.size() - 1)};
+    while ((child & node_subsector) == 0) {
+        const auto& node{nodes[child]};
+        child = node.children[pointOnSide(x, y, node)];
+    }
+    return &subsectors[child & ~node_subsector];
+}
+
+Uint32 Level::newValidCount() {
+    // Clear the stamps in the unlikely case that the count wraps, so that
+    // no line looks checked already.
+    if (++valid_count == 0) {
+        std::ranges::fill(line_stamps, 0);
+        valid_count = 1;
+    }
+    return valid_count;
+}
+
+void Level::enableMobjGrid() {
+    if (mobj_grid) {
+        return;
+    }
+    mobj_grid.emplace(blockmap);
+    thinkers.forEach([this](Thinker* thinker) {
+        auto& mobj{*static_cast<Mobj*>(thinker)};
+        if (inBlockmap(mobj)) {
+            mobj_grid->link(mobj);
+        }
+    });
+    mobj_grid->update();
+}
+
+Uint32 Level::newSoundCount() {
+    if (++sound_count == 0) {
+        for (auto& sector : sectors) {
+            sector.sound_stamp = 0;
+        }
+        sound_count = 1;
+    }
+    return sound_count;
+}
+
+bool Level::inBlockmap(const Mobj& mobj) const {
+    const auto block_x{blockmap.blockX(mobj.x)};
+    const auto block_y{blockmap.blockY(mobj.y)};
+    return (mobj.flags & mf_no_blockmap) == 0
+           && blockmap.contains(block_x, block_y);
+}
+
+void Level::linkMobj(Mobj& mobj) {
+    const auto subsector{pointInSubsector(mobj.x, mobj.y)};
+    mobj.sector = subsector ? subsector->sector : nullptr;
+    // Mobjs the blocks leave out are left out of the grid too, so that
+    // both find the same mobjs.
+    if (!inBlockmap(mobj)) {
+        if (mobj_grid) {
+            mobj_grid->unlink(mobj);
+        }
+        mobj.block_next = nullptr;
+        mobj.block_prev = nullptr;
+        return;
+    }
+    // The grid follows the mobj on its own, so it is only unlinked from
+    // it when the mobj leaves the blockmap or is removed.
+    if (mobj_grid) {
+        mobj_grid->link(mobj);
+    }
+    const auto block_x{blockmap.blockX(mobj.x)};
+    const auto block_y{blockmap.blockY(mobj.y)};
+    auto& first{block_mobjs[blockmap.blockIndex(block_x, block_y)]};
+    mobj.block_prev = nullptr;
+    mobj.block_next = first;
+    if (first) {
+        first->block_prev = &mobj;
+    }
+    first = &mobj;
+}
+
+void Level::unlinkMobj(Mobj& mobj) {
+    if (mobj.block_prev) {
+        mobj.block_prev->block_next = mobj.block_next;
+    } else if (inBlockmap(mobj)) {
+        const auto block_x{blockmap.blockX(mobj.x)};
+        const auto block_y{blockmap.blockY(mobj.y)};
+        const auto block{blockmap.blockIndex(block_x, block_y)};
+        block_mobjs[block] = mobj.block_next;
+    }
+    if (mobj.block_next) {
+        mobj.block_next->block_prev = mobj.block_prev;
+    }
+    mobj.block_next = nullptr;
+    mobj.block_prev = nullptr;
+}
+
+Mobj& Level::spawnMobj(
+    const fixed_t x,
+    const fixed_t y,
+    const fixed_t z,
+    const int type
+) {
+    const auto handle{mobjs.allocate()};
+    auto& mobj{*mobjs.get(handle)};
+    mobj.id = handle.index;
+    mobj.type = type;
+    mobj.x = x;
+    mobj.y = y;
+    mobj.z = z;
+    mobj.radius = default_radius;
+    mobj.height = default_height;
+    mobj.flags = default_flags;
+    linkMobj(mobj);
+    if (mobj.sector) {
+        mobj.floor_z = mobj.sector->floor_height;
+        mobj.ceiling_z = mobj.sector->ceiling_height;
+    }
+    thinkers.add(&mobj);
+    return mobj;
+}
+
+void Level::removeMobj(Mobj& mobj) {
+    if (mobj.removed) {
+        return;
+    }
+    unlinkMobj(mobj);
+    if (mobj_grid) {
+        mobj_grid->unlink(mobj);
+    }
+    mobj.removed = true;
+    if (running_thinkers) {
+        removed_mobjs.push_back(&mobj);
+        return;
+    }
+    thinkers.remove(&mobj);
+    mobjs.free(handleOf(mobj));
+}
+
+void Level::runThinkers() {
+    // Mobjs moved during the last tic, so its sight checks no longer hold.
+    sight_cache.invalidate();
+    if (mobj_grid) {
+        mobj_grid->update();
+    }
+    running_thinkers = true;
+    thinkers.forEach([this](Thinker* thinker) {
+        if (thinker->removed) {
+            return;
+        }
+        switch (thinker->kind) {
+        case ThinkerKind::Mobj: {
+            auto& mobj{*static_cast<Mobj*>(thinker)};
+            const auto moving{mobj.mom_x != 0 || mobj.mom_y != 0};
+            if (moving && !moveByMomentum(*this, mobj)) {
+                break;
+            }
+            if (mobj.tics > 0) {
+                mobj.tics--;
+            }
+            break;
+        }
+        }
+    });
+    running_thinkers = false;
+
+    for (const auto mobj : removed_mobjs) {
+        thinkers.remove(mobj);
+        mobjs.free(handleOf(*mobj));
+    }
+    removed_mobjs.clear();
+}
+
+
+static void writeTextureName(LumpWriter& writer, const TextureName& name) {
+    writer.write({reinterpret_cast<const Uint8*>(name.data()), name.size()});
+}
+
+template <typename T>
+static Sint32 indexOf(const std::span<T> elements, const T* element) {
+    return element ? static_cast<Sint32>(element - elements.data()) : -1;
+}
+
+// Slot of the mobj, or -1 for a handle to a removed one.
+static Sint32 slotOf(const SlabPool<Mobj>& mobjs, const MobjHandle handle) {
+    return mobjs.get(handle) ? static_cast<Sint32>(handle.index) : -1;
+}
+
+void Level::writeState(LumpWriter& writer) const {
+    writer.writeInt(static_cast<Sint32>(sectors.size()));
+    for (const auto& sector : sectors) {
+        writer.writeInt(sector.floor_height);
+        writer.writeInt(sector.ceiling_height);
+        writeTextureName(writer, sector.floor_pic);
+        writeTextureName(writer, sector.ceiling_pic);
+        writer.writeShort(sector.light_level);
+        writer.writeShort(sector.special);
+        writer.writeShort(sector.tag);
+    }
+    writer.writeInt(static_cast<Sint32>(lines.size()));
+    for (const auto& line : lines) {
+        writer.writeShort(line.flags);
+        writer.writeShort(line.special);
+        writer.writeShort(line.tag);
+    }
+    writer.writeInt(static_cast<Sint32>(sides.size()));
+    for (const auto& side : sides) {
+        writer.writeInt(side.texture_offset);
+        writer.writeInt(side.row_offset);
+        writeTextureName(writer, side.top_texture);
+        writeTextureName(writer, side.bottom_texture);
+        writeTextureName(writer, side.mid_texture);
+    }
+
+    // Thinkers are written in the order they run, mobjs keeping their
+    // slots so that the references between them can be written before
+    // the mobjs they refer to.
+    writer.writeInt(static_cast<Sint32>(mobjs.numSlots()));
+    thinkers.forEach([&](const Thinker* thinker) {
+        writer.writeByte(static_cast<Uint8>(thinker->kind));
+        const auto& mobj{*static_cast<const Mobj*>(thinker)};
+        writer.writeInt(static_cast<Sint32>(mobj.id));
+        writer.writeInt(mobj.type);
+        writer.writeInt(mobj.x);
+        writer.writeInt(mobj.y);
+        writer.writeInt(mobj.z);
+        writer.writeInt(static_cast<Sint32>(mobj.angle));
+        writer.writeInt(mobj.mom_x);
+        writer.writeInt(mobj.mom_y);
+        writer.writeInt(mobj.mom_z);
+        writer.writeInt(mobj.radius);
+        writer.writeInt(mobj.height);
+        writer.writeInt(mobj.floor_z);
+        writer.writeInt(mobj.ceiling_z);
+        writer.writeInt(static_cast<Sint32>(mobj.flags));
+        writer.writeInt(mobj.health);
+        writer.writeInt(mobj.tics);
+        writer.writeInt(indexOf(sectors, mobj.sector));
+        writer.writeInt(slotOf(mobjs, mobj.target));
+        writer.writeInt(slotOf(mobjs, mobj.tracer));
+    });
+    writer.writeByte(end_of_thinkers);
+    for (const auto& sector : sectors) {
+        writer.writeInt(slotOf(mobjs, sector.sound_target));
+    }
+}
+
+static void checkCount(LumpReader& reader, const size_t count) {
+    if (static_cast<size_t>(reader.readInt()) != count) {
+        throw domain_error{"Saved state is from another map"};
+    }
+}
+
+template <typename T>
+static T* elementAt(const std::span<T> elements, const Sint32 index) {
+    if (index < 0) {
+        return nullptr;
+    }
+    if (static_cast<size_t>(index) >= elements.size()) {
+        throw domain_error{"Saved state refers to a missing element"};
+    }
+    return &elements[index];
+}
+
+void Level::checkState(LumpReader reader) const {
+    checkCount(reader, sectors.size());
+    reader.readSpan(sectors.size() * saved_sector_size);
+    checkCount(reader, lines.size());
+    reader.readSpan(lines.size() * saved_line_size);
+    checkCount(reader, sides.size());
+    reader.readSpan(sides.size() * saved_side_size);
+
+    const auto slots{static_cast<Uint32>(reader.readInt())};
+    if (slots > max_saved_slots) {
+        throw domain_error{"Saved state has too many mobjs"};
+    }
+    const auto checkSlot{[&](const Sint32 slot) {
+        if (slot < 0 || static_cast<Uint32>(slot) >= slots) {
+            throw domain_error{"Saved state refers to a missing mobj"};
+        }
+        return static_cast<Uint32>(slot);
+    }};
+    // References to no mobj are saved as -1.
+    const auto checkReference{[&](const Sint32 slot) {
+        if (slot >= 0) {
+            checkSlot(slot);
+        }
+    }};
+    std::vector<bool> read_slots(slots);
+    for (auto kind{reader.readByte()}; kind != end_of_thinkers;
+         kind = reader.readByte()) {
+        if (kind != static_cast<Uint8>(ThinkerKind::Mobj)) {
+            throw domain_error{"Saved state has an unknown thinker"};
+        }
+        const auto slot{checkSlot(reader.readInt())};
+        if (read_slots[slot]) {
+            throw domain_error{"Saved state has a mobj twice"};
+        }
+        read_slots[slot] = true;
+        reader.readSpan(saved_mobj_fields_size);
+        elementAt(sectors, reader.readInt());
+        checkReference(reader.readInt());
+        checkReference(reader.readInt());
+    }
+    for (size_t i = 0; i < sectors.size(); i++) {
+        checkReference(reader.readInt());
+    }
+}
+
+void Level::readState(LumpReader& reader) {
+    checkState(reader);
+
+    // The sectors and mobjs read may be anywhere.
+    sight_cache.invalidate();
+    checkCount(reader, sectors.size());
+    for (auto& sector : sectors) {
+        sector.floor_height = reader.readInt();
+        sector.ceiling_height = reader.readInt();
+        sector.floor_pic = readTextureName(reader);
+        sector.ceiling_pic = readTextureName(reader);
+        sector.light_level = reader.readShort();
+        sector.special = reader.readShort();
+        sector.tag = reader.readShort();
+    }
+    checkCount(reader, lines.size());
+    for (auto& line : lines) {
+        line.flags = reader.readShort();
+        line.special = reader.readShort();
+        line.tag = reader.readShort();
+    }
+    checkCount(reader, sides.size());
+    for (auto& side : sides) {
+        side.texture_offset = reader.readInt();
+        side.row_offset = reader.readInt();
+        side.top_texture = readTextureName(reader);
+        side.bottom_texture = readTextureName(reader);
+        side.mid_texture = readTextureName(reader);
+    }
+
+    // Mobjs go back to the slots they were saved from. A slot keeps its
+    // generation until it is freed, so that references to mobjs not read
+    // yet can be resolved right away.
+    const auto slots{static_cast<Uint32>(reader.readInt())};
+    thinkers.clear();
+    mobjs.reset(slots);
+    const auto slotAt{[&](const Sint32 slot) -> Uint32 {
+        if (slot < 0 || static_cast<Uint32>(slot) >= slots) {
+            throw domain_error{"Saved state refers to a missing mobj"};
+        }
+        return static_cast<Uint32>(slot);
+    }};
+    const auto handleAt{[&](const Sint32 slot) -> MobjHandle {
+        return slot < 0 ? MobjHandle{} : mobjs.handleOf(slotAt(slot));
+    }};
+    for (auto kind{reader.readByte()}; kind != end_of_thinkers;
+         kind = reader.readByte()) {
+        if (kind != static_cast<Uint8>(ThinkerKind::Mobj)) {
+            throw domain_error{"Saved state has an unknown thinker"};
+        }
+        const auto slot{slotAt(reader.readInt())};
+        if (mobjs.isLive(slot)) {
+            throw domain_error{"Saved state has a mobj twice"};
+        }
+        auto& mobj{*mobjs.get(mobjs.allocateAt(slot))};
+        mobj.id = slot;
+        mobj.type = reader.readInt();
+        mobj.x = reader.readInt();
+        mobj.y = reader.readInt();
+        mobj.z = reader.readInt();
+        mobj.angle = static_cast<angle_t>(reader.readInt());
+        mobj.mom_x = reader.readInt();
+        mobj.mom_y = reader.readInt();
+        mobj.mom_z = reader.readInt();
+        mobj.radius = reader.readInt();
+        mobj.height = reader.readInt();
+        mobj.floor_z = reader.readInt();
+        mobj.ceiling_z = reader.readInt();
+        mobj.flags = static_cast<Uint32>(reader.readInt());
+        mobj.health = reader.readInt();
+        mobj.tics = reader.readInt();
+        mobj.sector = elementAt(sectors, reader.readInt());
+        mobj.target = handleAt(reader.readInt());
+        mobj.tracer = handleAt(reader.readInt());
+        thinkers.add(&mobj);
+    }
+    for (auto& sector : sectors) {
+        sector.sound_target = handleAt(reader.readInt());
+    }
+    mobjs.collectFreeSlots();
+
+    // The block links are rebuilt in the order the mobjs run.
+    std::ranges::fill(block_mobjs, nullptr);
+    if (mobj_grid) {
+        mobj_grid->clear();
+    }
+    thinkers.forEach([this](Thinker* thinker) {
+        linkMobj(*static_cast<Mobj*>(thinker));
+    });
+}
+
+string mapName(const WadManager& wad_manager, const GameSettings& settings) {
+    // Doom II names its maps by number alone.
+    if (wad_manager.hasLump("MAP01")) {
+        return std::format("MAP{:02}", settings.map);
+    }
+    return std::format("E{}M{}", settings.episode, settings.map);
+}
@@ -0,0 +1,423 @@
+#pragma once
+
+#include <SDL.h>
+#include <array>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include "blockmap.h"
+#include "fixed.h"
+#include "game.h"
+#include "mobj.h"
+#include "mobjgrid.h"
+#include "sight.h"
+#include "zone.h"
+
+class LumpReader;
+class LumpWriter;
+class WadManager;
+
+// Name of a texture or flat, padded with zeroes.
+using TextureName = std::array<char, 8>;
+
+struct Vertex {
+    fixed_t x;
+    fixed_t y;
+};
+
+struct Sector {
+    fixed_t floor_height;
+    fixed_t ceiling_height;
+    TextureName floor_pic;
+    TextureName ceiling_pic;
+    Sint16 light_level;
+    Sint16 special;
+    Sint16 tag;
+    // Mobj whose noise last reached the sector.
+    MobjHandle sound_target;
+    // Noise that last reached the sector, and one more than the number of
+    // sound blocking lines it came through.
+    Uint32 sound_stamp;
+    int sound_traversed;
+};
+
+/**
+ * Sector next to another through a two-sided line, and whether every
+ * line between them blocks sound.
+ */
+struct SectorLink {
+    Uint32 sector;
+    bool sound_block;
+};
+
+struct Side {
+    fixed_t texture_offset;
+    fixed_t row_offset;
+    TextureName top_texture;
+    TextureName bottom_texture;
+    TextureName mid_texture;
+    Sector* sector;
+};
+
+// Index of the box sides in a bounding box.
+enum BoxSide {
+    box_top,
+    box_bottom,
+    box_left,
+    box_right,
+};
+
+using BoundingBox = std::array<fixed_t, 4>;
+
+// Line flags.
+static constexpr Sint16 ml_blocking{1};
+static constexpr Sint16 ml_block_monsters{2};
+static constexpr Sint16 ml_two_sided{4};
+static constexpr Sint16 ml_sound_block{0x40};
+
+struct Line {
+    Vertex* v1;
+    Vertex* v2;
+    fixed_t dx;
+    fixed_t dy;
+    Sint16 flags;
+    Sint16 special;
+    Sint16 tag;
+    // Front and back side, the back one only on two-sided lines.
+    std::array<Side*, 2> sides;
+    Sector* front_sector;
+    Sector* back_sector;
+    BoundingBox bbox;
+};
+
+struct Seg {
+    Vertex* v1;
+    Vertex* v2;
+    fixed_t offset;
+    angle_t angle;
+    Side* side;
+    Line* line;
+    Sector* front_sector;
+    Sector* back_sector;
+};
+
+struct Subsector {
+    Sector* sector;
+    int num_segs;
+    int first_seg;
+};
+
+// Children of a node with this bit set are subsectors.
+static constexpr Uint16 node_subsector{0x8000};
+
+struct Node {
+    // Partition line.
+    fixed_t x;
+    fixed_t y;
+    fixed_t dx;
+    fixed_t dy;
+    // Bounding boxes and children of the right and left side.
+    std::array<BoundingBox, 2> bbox;
+    std::array<Uint16, 2> children;
+};
+
+/**
+ * The line fields that collision checks read, one array per field.
+ * Checking a block walks the bounding boxes of its lines through a few
+ * cache lines and rejects most of them before anything else is read.
+ */
+struct CollisionLines {
+    std::span<fixed_t> left{};
+    std::span<fixed_t> right{};
+    std::span<fixed_t> bottom{};
+    std::span<fixed_t> top{};
+    std::span<fixed_t> x{};
+    std::span<fixed_t> y{};
+    std::span<fixed_t> dx{};
+    std::span<fixed_t> dy{};
+};
+
+struct MapThing {
+    fixed_t x;
+    fixed_t y;
+    angle_t angle;
+    int type;
+    int options;
+};
+
+/**
+ * A map: its geometry, loaded from the map lumps, and the thinkers
+ * running in it.
+ */
+class Level {
+    // The map data is allocated under the level tag, and freed at once
+    // with the level.
+    std::optional<ZoneArena> arena{};
+    std::span<Vertex> vertexes{};
+    std::span<Sector> sectors{};
+    std::span<Side> sides{};
+    std::span<Line> lines{};
+    std::span<Seg> segs{};
+    std::span<Subsector> subsectors{};
+    std::span<Node> nodes{};
+    std::array<std::optional<MapThing>, max_players> player_starts{};
+
+    Blockmap blockmap{};
+    CollisionLines collision_lines{};
+    // Mobjs whose center is in each block, most recently linked first.
+    std::span<Mobj*> block_mobjs{};
+    // Lines are stamped with the number of the check that last looked
+    // at them, so that a line crossing several blocks is checked once
+    // without clearing anything between checks.
+    std::span<Uint32> line_stamps{};
+    Uint32 valid_count{0};
+    // Mobjs sorted into a finer grid, which collision checks search
+    // instead of the blocks when there is one.
+    std::optional<MobjGrid> mobj_grid{};
+
+    // Bit s1 * sectors + s2 is set if nothing in sector s2 can be seen
+    // from sector s1.
+    std::span<Uint8> reject{};
+    SightCache sight_cache{};
+    SightStats sight_stats{};
+
+    // Sectors next to sector s are sector_links[sector_link_starts[s],
+    // sector_link_starts[s + 1]), for noise to flood through.
+    std::span<Uint32> sector_link_starts{};
+    std::span<SectorLink> sector_links{};
+    // Sectors reached by the noise being propagated, in the order they
+    // were, without and with crossing a sound blocking line.
+    std::span<Uint32> sound_queues{};
+    Uint32 sound_count{0};
+
+    SlabPool<Mobj> mobjs{};
+    ThinkerList thinkers{};
+    // Mobjs removed while the thinkers run, freed once they all did.
+    bool running_thinkers{false};
+    std::vector<Mobj*> removed_mobjs{};
+
+    void loadVertexes(LumpReader reader);
+    void loadSectors(LumpReader reader);
+    void loadSides(LumpReader reader);
+    void loadLines(LumpReader reader);
+    void loadSegs(LumpReader reader);
+    void loadSubsectors(LumpReader reader);
+    void loadNodes(LumpReader reader);
+    void loadThings(LumpReader reader, const GameSettings& settings);
+    void loadBlockmap(LumpReader reader);
+    void loadReject(LumpReader reader);
+    void linkSectors();
+
+    // Throw if the state cannot be read, before readState() changes
+    // anything.
+    void checkState(LumpReader reader) const;
+
+    // Whether the mobj is linked into a block, and into the grid if the
+    // level has one: it is in the blockmap and not kept out of it.
+    [[nodiscard]]
+    bool inBlockmap(const Mobj& mobj) const;
+
+  public:
+    // Empty level, with no geometry.
+    Level() = default;
+
+    Level(WadManager& wad_manager, const GameSettings& settings);
+
+    Level(Level& other) = delete;
+    Level& operator=(const Level& other) = delete;
+
+    [[nodiscard]]
+    const std::optional<MapThing>& getPlayerStart(const int player) const {
+        return player_starts[player];
+    }
+
+    // The mobj, or null if it was removed.
+    [[nodiscard]]
+    Mobj* getMobj(const MobjHandle handle) const {
+        return mobjs.get(handle);
+    }
+
+    [[nodiscard]]
+    MobjHandle handleOf(const Mobj& mobj) const {
+        return mobjs.handleOf(mobj.id);
+    }
+
+    [[nodiscard]]
+    Uint32 getNumMobjs() const {
+        return mobjs.size();
+    }
+
+    /**
+     * Call f(mobj) on every mobj in memory order, which is faster than
+     * following the thinker list but in no particular order, so only for
+     * passes where the order doesn't matter.
+     */
+    template <typename F>
+    void forEachMobj(F f) const {
+        mobjs.forEach(f);
+    }
+
+    [[nodiscard]]
+    std::span<const Line> getLines() const {
+        return lines;
+    }
+
+    [[nodiscard]]
+    const Line& getLine(const Uint32 index) const {
+        return lines[index];
+    }
+
+    [[nodiscard]]
+    Uint32 lineIndex(const Line& line) const {
+        return static_cast<Uint32>(&line - lines.data());
+    }
+
+    [[nodiscard]]
+    Uint32 sectorIndex(const Sector& sector) const {
+        return static_cast<Uint32>(&sector - sectors.data());
+    }
+
+    [[nodiscard]]
+    std::span<Sector> getSectors() const {
+        return sectors;
+    }
+
+    [[nodiscard]]
+    std::span<const Side> getSides() const {
+        return sides;
+    }
+
+    [[nodiscard]]
+    std::span<const SectorLink> getSectorLinks(const Uint32 sector) const {
+        const auto start{sector_link_starts[sector]};
+        const auto count{sector_link_starts[sector + 1] - start};
+        return sector_links.subspan(start, count);
+    }
+
+    // Start propagating a noise, returning its stamp.
+    Uint32 newSoundCount();
+
+    // Room for two queues of every sector.
+    [[nodiscard]]
+    std::span<Uint32> getSoundQueues() const {
+        return sound_queues;
+    }
+
+    [[nodiscard]]
+    std::span<const Seg> getSegs() const {
+        return segs;
+    }
+
+    [[nodiscard]]
+    std::span<const Subsector> getSubsectors() const {
+        return subsectors;
+    }
+
+    [[nodiscard]]
+    std::span<const Node> getNodes() const {
+        return nodes;
+    }
+
+    // Whether the REJECT lump rules out seeing anything in one sector
+    // from the other.
+    [[nodiscard]]
+    bool rejectsSight(const Sector& from, const Sector& to) const {
+        const auto bit{sectorIndex(from) * sectors.size() + sectorIndex(to)};
+        return (reject[bit >> 3] >> (bit & 7)) & 1;
+    }
+
+    // Stop answering sight checks from REJECT, or from the cache, to
+    // measure what they save. Neither changes what a check returns.
+    void disableReject();
+    void disableSightCache();
+
+    [[nodiscard]]
+    SightCache& getSightCache() {
+        return sight_cache;
+    }
+
+    // How the sight checks since the level was loaded were answered.
+    [[nodiscard]]
+    SightStats& getSightStats() {
+        return sight_stats;
+    }
+
+    [[nodiscard]]
+    const SightStats& getSightStats() const {
+        return sight_stats;
+    }
+
+    [[nodiscard]]
+    const CollisionLines& getCollisionLines() const {
+        return collision_lines;
+    }
+
+    [[nodiscard]]
+    const Blockmap& getBlockmap() const {
+        return blockmap;
+    }
+
+    // First mobj linked into a block inside the map.
+    [[nodiscard]]
+    Mobj* firstMobjIn(const int block_x, const int block_y) const {
+        return block_mobjs[blockmap.blockIndex(block_x, block_y)];
+    }
+
+    // Start a check of the lines around a position, returning its stamp.
+    Uint32 newValidCount();
+
+    [[nodiscard]]
+    std::span<Uint32> getLineStamps() const {
+        return line_stamps;
+    }
+
+    // Keep the mobjs in a MobjGrid too, for maps where thousands of them
+    // crowd into the same blocks.
+    void enableMobjGrid();
+
+    [[nodiscard]]
+    MobjGrid* getMobjGrid() {
+        return mobj_grid ? &*mobj_grid : nullptr;
+    }
+
+    // Link the mobj into the sector and block of its position, or unlink
+    // it before it moves.
+    void linkMobj(Mobj& mobj);
+    void unlinkMobj(Mobj& mobj);
+
+    // Subsector containing the point, or null on an empty level.
+    [[nodiscard]]
+    const Subsector* pointInSubsector(fixed_t x, fixed_t y) const;
+
+    Mobj& spawnMobj(fixed_t x, fixed_t y, fixed_t z, int type);
+
+    /**
+     * Take the mobj out of the blockmap, stop it from thinking and free
+     * it. Any thinker may remove any mobj, so while the thinkers run the
+     * mobj is only freed once they all did, and its handles resolve
+     * until then, as in the original.
+     */
+    void removeMobj(Mobj& mobj);
+
+    void runThinkers();
+
+    /**
+     * Write what changes in play: the sector, line and side fields that
+     * specials change, and every thinker. Pointers are written as
+     * indexes into the level's arrays, or as mobj slots.
+     */
+    void writeState(LumpWriter& writer) const;
+
+    // Read back a state written by the same map. A state that cannot be
+    // read throws and leaves the level as it was.
+    void readState(LumpReader& reader);
+};
+
+// Lump name of the map the settings start on.
+[[nodiscard]]
+std::string mapName(
+    const WadManager& wad_manager,
+    const GameSettings& settings
+);
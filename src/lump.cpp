@@ -0,0 +1,73 @@
+#include "lump.h"
+#include <algorithm>
+#include <format>
+
+using std::domain_error;
+using std::string;
+
+
+void LumpReader::seek(const size_t new_pos) {
+    if (new_pos > data.size()) {
+        const auto error{std::format("Invalid lump offset {}", new_pos)};
+        throw domain_error{error};
+    }
+    pos = new_pos;
+}
+
+void LumpReader::read(Uint8* buffer, const size_t count) {
+    const auto bytes{readSpan(count)};
+    std::copy(bytes.begin(), bytes.end(), buffer);
+}
+
+std::span<const Uint8> LumpReader::readSpan(const size_t count) {
+    if (count > data.size() - pos) {
+        const auto error{std::format("Failed to extract {} bytes", count)};
+        throw domain_error{error};
+    }
+    const auto bytes{data.subspan(pos, count)};
+    pos += count;
+    return bytes;
+}
+
+Sint32 LumpReader::readInt() {
+    Sint32 i{};
+    read((Uint8*) &i, sizeof(i));
+    return SDL_SwapLE32(i);
+}
+
+Sint16 LumpReader::readShort() {
+    Sint16 i{};
+    read((Uint8*) &i, sizeof(i));
+    return SDL_SwapLE16(i);
+}
+
+Uint8 LumpReader::readByte() {
+    Uint8 i{};
+    read(&i, sizeof(i));
+    return i;
+}
+
+string LumpReader::readString(const size_t size) {
+    string buffer(size, '\0');
+    read((Uint8*) buffer.data(), size);
+    // Remove any trailing zeroes.
+    const auto end{buffer.find('\0')};
+    if (end != string::npos) {
+        buffer.resize(end);
+    }
+    return buffer;
+}
+
+
+void LumpWriter::writeInt(const Sint32 i) {
+    const auto value{static_cast<Uint32>(i)};
+    for (int byte = 0; byte < 4; byte++) {
+        data.push_back(static_cast<Uint8>(value >> (byte * 8)));
+    }
+}
+
+void LumpWriter::writeShort(const Sint16 i) {
+    const auto value{static_cast<Uint16>(i)};
+    data.push_back(static_cast<Uint8>(value));
+    data.push_back(static_cast<Uint8>(value >> 8));
+}
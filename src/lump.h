@@ -0,0 +1,71 @@
+#pragma once
+
+#include <SDL.h>
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * Sequential reader over the raw data of a lump, with the same
+ * interface as WadReader. Lump data comes from files that may be
+ * malformed, so every read is bounds checked.
+ */
+class LumpReader {
+    std::span<const Uint8> data;
+    size_t pos{};
+
+  public:
+    explicit LumpReader(std::span<const Uint8> data)
+        : data{data} {
+    }
+
+    [[nodiscard]]
+    size_t size() const {
+        return data.size();
+    }
+
+    [[nodiscard]]
+    size_t tell() const {
+        return pos;
+    }
+
+    void seek(size_t new_pos);
+
+    void read(Uint8* buffer, size_t count);
+
+    // View of the next count bytes, without copying them.
+    std::span<const Uint8> readSpan(size_t count);
+
+    Sint32 readInt();
+
+    Sint16 readShort();
+
+    Uint8 readByte();
+
+    std::string readString(size_t size);
+};
+
+/**
+ * Appends little-endian values to a buffer, the counterpart of
+ * LumpReader for data the engine writes itself.
+ */
+class LumpWriter {
+    std::vector<Uint8>& data;
+
+  public:
+    explicit LumpWriter(std::vector<Uint8>& data)
+        : data{data} {
+    }
+
+    void write(std::span<const Uint8> bytes) {
+        data.insert(data.end(), bytes.begin(), bytes.end());
+    }
+
+    void writeInt(Sint32 i);
+
+    void writeShort(Sint16 i);
+
+    void writeByte(const Uint8 i) {
+        data.push_back(i);
+    }
+};
@@ -1,296 +1,510 @@
 #include <SDL.h>
-#include <filesystem>
+#include <algorithm>
+#include <array>
 #include <format>
 #include <fstream>
-#include <string>
-#include <unordered_map>
+#include <iostream>
+#include "args.h"
+#include "bench.h"
+#include "colormaps.h"
+#include "demo.h"
+#include "game.h"
+#include "hud.h"
+#include "input.h"
+#include "level.h"
+#include "renderer.h"
+#include "savegame.h"
+#include "snapshot.h"
+#include "stats.h"
+#include "textures.h"
+#include "verify.h"
+#include "video.h"
+#include "wad.h"
 #include "window.h"
+#include "workers.h"
+#include "zone.h"
 
-using std::domain_error;
-using std::ifstream;
-using std::optional;
-using std::string;
-using std::string_view;
-using std::vector;
-using std::filesystem::path;
 
+int main(int argc, char* argv[]) {
+    const Arguments args{argc, argv};
+    const auto video_mode{VideoMode::fromArguments(args)};
 
-class WadReader {
-    ifstream wad;
-
-  public:
-    explicit WadReader(const path& wad_file)
-        : wad{wad_file, std::ios::binary} {
-        wad.exceptions(ifstream::failbit | ifstream::badbit);
-    }
-
-    WadReader(WadReader&& other) noexcept = default;
+    // Lumps, levels and renderer scratch memory are allocated in the zone,
+    // whose memory -zonestats prints at the end.
+    Zone zone;
+    WadManager wad_manager{zone};
+    wad_manager.addWad("doom.wad");
 
-    void seek(const std::streamoff pos) {
-        wad.seekg(pos);
+    const auto render_threads{args.getInt("-threads").value_or(1)};
+    const auto num_threads{static_cast<size_t>(std::max(render_threads, 1))};
+    WorkerGroup workers{num_threads};
+
+    // -verifydemos <demo>... plays back every demo without rendering,
+    // on -threads workers, and reports whether each stayed in sync.
+    if (const auto demo_names{args.getValues("-verifydemos")};
+        !demo_names.empty()) {
+        const auto results{verifyDemos(wad_manager, demo_names, workers)};
+        printResults(std::cout, results);
+        const auto passed{std::ranges::all_of(results, &DemoResult::passed)};
+        return passed ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
-    void read(char* buffer, const std::streamsize count) {
-        wad.read(buffer, count);
-        if (wad.gcount() != count) {
-            const auto error{std::format("Failed to extract {} bytes", count)};
-            throw domain_error{error};
+    // -benchmove <tics> walks every mobj of the first level around for
+    // that many tics and reports the time spent moving them, and then
+    // the time spent finding the mobjs around each of them as often,
+    // with the blocks and with a MobjGrid.
+    if (const auto move_tics{args.getInt("-benchmove")}) {
+        const auto tics{static_cast<size_t>(std::max(*move_tics, 0))};
+        for (const auto mobj_grid : {false, true}) {
+            printMoveBenchmark(
+                std::cout,
+                benchmarkMovement(wad_manager, GameSettings{}, tics, mobj_grid)
+            );
+        }
+        for (const auto mobj_grid : {false, true}) {
+            printQueryBenchmark(
+                std::cout,
+                benchmarkQueries(wad_manager, GameSettings{}, tics, mobj_grid)
+            );
         }
+        return EXIT_SUCCESS;
     }
 
-    Sint32 readInt() {
-        Sint32 i{};
-        read((char*) &i, sizeof(i));
-        return SDL_SwapLE32(i);
+    // -benchsight <tics> has every mobj of the first level look at
+    // another one for that many tics and reports the sight check time,
+    // with the mobjs standing and walking around, and with REJECT and
+    // the sight cache, the cache alone off and both off.
+    if (const auto sight_tics{args.getInt("-benchsight")}) {
+        const auto tics{static_cast<size_t>(std::max(*sight_tics, 0))};
+        constexpr std::array<std::pair<bool, bool>, 3> shortcuts{{
+            {true, true},
+            {true, false},
+            {false, false},
+        }};
+        for (const auto moving : {false, true}) {
+            for (const auto& [reject, cache] : shortcuts) {
+                printSightBenchmark(
+                    std::cout,
+                    benchmarkSight(
+                        wad_manager,
+                        GameSettings{},
+                        tics,
+                        moving,
+                        reject,
+                        cache
+                    )
+                );
+            }
+        }
+        return EXIT_SUCCESS;
     }
 
-    Sint16 readShort() {
-        Sint16 i{};
-        read((char*) &i, sizeof(i));
-        return SDL_SwapLE16(i);
+    // -benchnoise <rounds> makes a noise in every sector of the first
+    // level that many times, with random doors shut, and reports the
+    // time noiseAlert() and the original recursion take and any sector
+    // they leave differently.
+    if (const auto noise_rounds{args.getInt("-benchnoise")}) {
+        const auto rounds{static_cast<size_t>(std::max(*noise_rounds, 0))};
+        const auto result{benchmarkNoise(wad_manager, GameSettings{}, rounds)};
+        printComparison(std::cout, "noise alerts", "alert", result);
+        return result.mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
-    string readString(const std::streamsize size) {
-        vector<char> buffer(size);
-        read(buffer.data(), size);
-        // Remove any trailing zeroes.
-        size_t i = 0;
-        for (; i < size; i++) {
-            if (buffer[i] == '\0') {
-                break;
+    // -benchlayout <frames> draws and presents that many frames in each
+    // render buffer layout, at the native resolution and a few larger
+    // ones, and reports the time spent in each stage.
+    if (const auto layout_frames{args.getInt("-benchlayout")}) {
+        const auto frames{static_cast<size_t>(std::max(*layout_frames, 0))};
+        constexpr std::array<std::pair<int, int>, 4> sizes{{
+            {native_width, native_height},
+            {2 * native_width, 2 * native_height},
+            {1920, 1080},
+            {3840, 2160},
+        }};
+        for (const auto& [width, height] : sizes) {
+            for (const auto layout :
+                 {FrameLayout::RowMajor, FrameLayout::ColumnMajor}) {
+                printLayoutBenchmark(
+                    std::cout, benchmarkLayout(layout, width, height, frames)
+                );
             }
         }
-        return {buffer.data(), i};
+        return EXIT_SUCCESS;
     }
-};
-
 
-struct WadHeader {
-    // The ASCII characters "IWAD" or "PWAD".
-    string id;
-
-    // An integer specifying the number of lumps in the WAD.
-    Sint32 num_lumps;
-
-    // An integer holding a pointer to the location of the directory.
-    Sint32 directory_ofs;
-
-    explicit WadHeader(WadReader& reader)
-        : id{reader.readString(4)}
-        , num_lumps{reader.readInt()}
-        , directory_ofs{reader.readInt()} {
-        if (id != "IWAD" && id != "PWAD") {
-            const auto error{"WAD contains invalid id"};
-            throw domain_error{error};
-        }
-        if (num_lumps <= 0) {
-            const auto error{"WAD contains invalid number of lumps"};
-            throw domain_error{error};
-        }
-        if (directory_ofs <= 0) {
-            const auto error{"WAD contains invalid directory offset"};
-            throw domain_error{error};
-        }
-    }
-};
-
-struct WadLump {
-    // An integer holding a pointer to the start of the lump's data in the file.
-    Sint32 position;
-
-    // An integer representing the size of the lump in bytes.
-    Sint32 size;
-
-    // An ASCII string defining the lump's name. The name has a limit
-    // of 8 characters, the same as the main portion of an MS-DOS filename.
-    string name;
-
-    explicit WadLump(WadReader& reader)
-        : position{reader.readInt()}
-        , size{reader.readInt()}
-        , name{reader.readString(8)} {
-        if (position < 0) {
-            const auto error{
-                std::format("Lump \"{}\" contains invalid data offset!", name)
-            };
-            throw domain_error{error};
-        }
-        if (size < 0) {
-            const auto error{
-                std::format("Lump \"{}\" contains invalid size!", name)
-            };
-            throw domain_error{error};
+    // -benchstrips <frames> renders that many frames of a workload that
+    // moves across the view, in strips on the -threads workers with the
+    // strips kept in place and balanced, and in one strip. It reports
+    // the frame times and any pixel the strips drew differently. The
+    // frames are sized as -scale, -width and -height select.
+    if (const auto strip_frames{args.getInt("-benchstrips")}) {
+        const auto frames{static_cast<size_t>(std::max(*strip_frames, 0))};
+        auto passed{true};
+        for (const auto balance : {false, true}) {
+            const auto result{benchmarkStrips(
+                workers, video_mode.width, video_mode.height, frames, balance
+            )};
+            const auto label{balance ? "balanced strips" : "fixed strips"};
+            printComparison(std::cout, label, "frame", result);
+            passed = passed && result.mismatches == 0;
         }
+        return passed ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
-    [[nodiscard]]
-    bool isMarker() const {
-        return size == 0;
-    }
-};
-
-class WadDirectory {
-    vector<WadLump> lumps{};
-    std::unordered_map<string_view, Sint32> lump_map{};
-
-  public:
-    WadDirectory(WadReader& reader, const WadHeader& header) {
-        const auto num_lumps{header.num_lumps};
-        reader.seek(header.directory_ofs);
-        lumps.reserve(num_lumps);
-        lump_map.reserve(num_lumps);
-        for (Sint32 i = 0; i < num_lumps; i++) {
-            lumps.emplace_back(reader);
-            lump_map.try_emplace(lumps[i].name, i);
-        }
+    // -benchplanes <frames> asks for the visplanes of that many frames
+    // of random walls with the plane hash and with the linear search of
+    // the original, and reports their times and any plane or span that
+    // differs. The frames are sized as -scale, -width and -height select.
+    if (const auto plane_frames{args.getInt("-benchplanes")}) {
+        const auto frames{static_cast<size_t>(std::max(*plane_frames, 0))};
+        const auto result{
+            benchmarkPlanes(video_mode.width, video_mode.height, frames)
+        };
+        printComparison(std::cout, "visplanes", "request", result);
+        return result.mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
-    WadDirectory(WadDirectory&& other) noexcept = default;
-
-    [[nodiscard]]
-    optional<Sint32> searchLump(const string_view lump_name) const {
-        const auto lump_index{lump_map.find(lump_name)};
-        if (lump_index == lump_map.end()) {
-            return std::nullopt;
+    // -benchsprites <frames> sorts and clips the sprites of that many
+    // frames of random drawsegs, in views with a few and with thousands
+    // of sprites, with the radix sort and drawseg bins and with the
+    // selection sort and drawseg walk of the original. It reports their
+    // times and any sprite drawn in another order or clipped otherwise.
+    // The frames are sized as -scale, -width and -height select.
+    if (const auto sprite_frames{args.getInt("-benchsprites")}) {
+        const auto frames{static_cast<size_t>(std::max(*sprite_frames, 0))};
+        auto passed{true};
+        for (const auto sprites : {size_t{128}, size_t{2048}}) {
+            const auto result{benchmarkSprites(
+                video_mode.width, video_mode.height, sprites, frames
+            )};
+            const auto label{std::format("{} sprites", sprites)};
+            printComparison(std::cout, label, "sprite", result);
+            passed = passed && result.mismatches == 0;
         }
-        return lump_index->second;
+        return passed ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
-    [[nodiscard]]
-    const WadLump& getLump(const Sint32 lump_index) const {
-        if (lump_index < 0 || lump_index >= lumps.size()) {
-            throw domain_error{"No valid lump index"};
+    // -benchspans <frames> draws a random span on every row of that many
+    // frames with the scalar and the vectorized span drawers, in 8-bit
+    // and in true color, and reports their times and any difference in
+    // what they drew. The frames are sized as the -scale, -width and
+    // -height parameters select.
+    if (const auto span_frames{args.getInt("-benchspans")}) {
+        const auto frames{static_cast<size_t>(std::max(*span_frames, 0))};
+        auto passed{true};
+        for (const auto true_color : {false, true}) {
+            const auto result{benchmarkSpans(
+                video_mode.width, video_mode.height, true_color, frames
+            )};
+            const auto label{
+                true_color ? "true color spans" : "8-bit spans"
+            };
+            printComparison(std::cout, label, "span", result);
+            passed = passed && result.mismatches == 0;
         }
-        return lumps[lump_index];
-    }
-};
-
-/**
- * A WAD file consists of a header, a directory, and the data lumps
- * that make up the resources stored within the file. A WAD file can
- * be of two types:
- * - IWAD: An "Internal WAD" (or "Initial WAD"), or a core WAD that is
- *   loaded automatically by the engine and generally provides all the
- *   data required to run the game.
- * - PWAD: A "Patch WAD", or an optional file that replaces data from
- *   the IWAD loaded or provides additional data to the engine.
- */
-class WadFile {
-    WadReader reader;
-    WadHeader header;
-    WadDirectory directory;
-
-  public:
-    explicit WadFile(const path& wad_file)
-        : reader{wad_file}
-        , header{reader}
-        , directory{reader, header} {
-    }
-
-    WadFile(WadFile&& other) noexcept = default;
-
-    [[nodiscard]]
-    optional<Sint32> searchLump(const string_view lump_name) const {
-        return directory.searchLump(lump_name);
+        return passed ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
-    [[nodiscard]]
-    const WadLump& getLump(const Sint32 lump_index) const {
-        return directory.getLump(lump_index);
+    // -benchproject <rounds> moves that many rounds of random points into
+    // view space and scales them, one at a time and vectorized, and
+    // reports their times and any difference in the results.
+    if (const auto project_rounds{args.getInt("-benchproject")}) {
+        const auto rounds{static_cast<size_t>(std::max(*project_rounds, 0))};
+        const auto result{benchmarkProjection(1024, rounds)};
+        printComparison(std::cout, "projection", "point", result);
+        return result.mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
-    [[nodiscard]]
-    vector<Uint8> getLumpData(const Sint32 lump_index) {
-        const auto lump{getLump(lump_index)};
-        vector<Uint8> lump_data(lump.size);
-        reader.seek(lump.position);
-        reader.read((char*) lump_data.data(), lump.size);
-        return lump_data;
-    }
-};
-
-
-struct LumpIndex {
-    size_t wad;
-    Sint32 lump;
+    TextureManager texture_manager{wad_manager};
 
-    LumpIndex(const size_t wad, const Sint32 lump)
-        : wad{wad}
-        , lump{lump} {
+    if (!video_mode.headless) {
+        SDL_InitSubSystem(SDL_INIT_VIDEO);
     }
-
-    friend LumpIndex operator+(const LumpIndex& index, const Sint32& inc) {
-        return {index.wad, index.lump + inc};
+    Window window{video_mode};
+    window.setPalette(wad_manager.getLumpData("PLAYPAL").data());
+    const ColorTables color_tables{wad_manager, workers, "tranmap.dat"};
+    const auto frame{window.getFrameBuffer()};
+    StatusBar status_bar{wad_manager, frame, color_tables};
+
+    // The view is rendered above the status bar.
+    auto view_frame{frame};
+    view_frame.height = status_bar.getArea().y;
+    Renderer renderer{view_frame, workers, zone};
+    const SDL_Rect view_area{0, 0, view_frame.width, view_frame.height};
+
+    // -playdemo <demo> plays back a demo at normal speed, -timedemo <demo>
+    // runs one tic per frame as fast as possible and reports frame time
+    // statistics at the end, optionally writing the timing of every frame
+    // to -timedemocsv <file>.
+    std::optional<Demo> demo{};
+    const auto timedemo_name{args.getValue("-timedemo")};
+    const auto demo_name{
+        timedemo_name ? timedemo_name : args.getValue("-playdemo")
+    };
+    if (demo_name) {
+        demo = Demo::load(wad_manager, *demo_name);
     }
-
-    friend LumpIndex operator+(const Sint32& inc, const LumpIndex& index) {
-        return index + inc;
-    }
-};
-
-class WadManager {
-    vector<WadFile> files{};
-
-    [[nodiscard]]
-    optional<LumpIndex> searchLump(const string_view lump_name) const {
-        for (size_t i = 0; i < files.size(); i++) {
-            auto lump{files[i].searchLump(lump_name)};
-            if (lump.has_value()) {
-                return LumpIndex{i, *lump};
-            }
+    const auto csv_file{args.getValue("-timedemocsv")};
+    FrameStats frame_stats;
+
+    // -loadgame <file> starts from a savegame. F6 saves the game to the
+    // quicksave file and F9 loads it back.
+    const std::filesystem::path quicksave_file{"quicksave.dsg"};
+    std::vector<Uint8> savegame{};
+    GameSettings settings{};
+    if (const auto load_file{args.getValue("-loadgame")}; load_file && !demo) {
+        try {
+            savegame = loadSaveGame(std::filesystem::path{*load_file});
+            settings = readSaveGameSettings(savegame);
+        } catch (const std::exception& e) {
+            std::cerr << std::format("Could not load game: {}\n", e.what());
+            savegame.clear();
         }
-        return std::nullopt;
     }
-
-  public:
-    void addWad(const path& wad_file) {
-        files.emplace_back(wad_file);
+    Game game{demo ? demo->getSettings() : settings, wad_manager};
+    // -mobjgrid keeps the mobjs in a grid for collision checks, which
+    // is faster when thousands of them crowd together.
+    if (args.hasParam("-mobjgrid")) {
+        game.getLevel().enableMobjGrid();
     }
-
-    [[nodiscard]]
-    bool hasLump(const string_view lump_name) const {
-        return searchLump(lump_name) != std::nullopt;
+    if (!savegame.empty()) {
+        try {
+            readSaveGame(game, savegame);
+        } catch (const std::exception& e) {
+            std::cerr << std::format("Could not load game: {}\n", e.what());
+        }
     }
 
-    [[nodiscard]]
-    LumpIndex getLumpIndex(const string_view lump_name) const {
-        if (const auto lump_index{searchLump(lump_name)}) {
-            return *lump_index;
+    // Build the wall textures of the level up front, on the workers,
+    // instead of in the middle of the first frames that show them.
+    std::vector<Sint32> level_textures{};
+    for (const auto& side : game.getLevel().getSides()) {
+        for (const auto& name :
+             {side.top_texture, side.bottom_texture, side.mid_texture}) {
+            const std::string_view padded{name.data(), name.size()};
+            const auto texture_name{padded.substr(0, padded.find('\0'))};
+            const auto texture{texture_manager.searchTexture(texture_name)};
+            if (texture) {
+                level_textures.push_back(*texture);
+            }
         }
-        const auto error{std::format("Could not find lump \"{}\"", lump_name)};
-        throw domain_error{error};
     }
-
-    [[nodiscard]]
-    vector<Uint8> getLumpData(const LumpIndex& lump_index) {
-        WadFile& wad{files[lump_index.wad]};
-        const auto lump{lump_index.lump};
-        return wad.getLumpData(lump);
+    std::ranges::sort(level_textures);
+    const auto duplicates{std::ranges::unique(level_textures)};
+    level_textures.erase(duplicates.begin(), duplicates.end());
+    texture_manager.warm(level_textures, workers);
+
+    const auto num_players{
+        static_cast<size_t>(game.getSettings().numPlayers())
+    };
+
+    // -record <file> records the game into a demo.
+    std::optional<DemoRecorder> recorder{};
+    if (const auto record_file{args.getValue("-record")}) {
+        const std::filesystem::path path{*record_file};
+        recorder.emplace(path, game.getSettings());
     }
-
-    [[nodiscard]]
-    vector<Uint8> getLumpData(const string_view lump_name) {
-        const auto lump_index{getLumpIndex(lump_name)};
-        return getLumpData(lump_index);
+    std::optional<DesyncDetector> desync_detector{};
+    if (demo) {
+        desync_detector.emplace(*demo);
     }
-};
 
+    // Demos played back can be seeked with Page Up and Page Down, which
+    // restore the snapshots taken every few seconds of the demo.
+    constexpr Uint32 snapshot_interval{10 * tic_rate};
+    constexpr Sint64 seek_tics{10 * tic_rate};
+    SnapshotTimeline timeline{snapshot_interval};
+    timeline.capture(game);
+
+    // Backspace rewinds a live game by a second, to the snapshots kept in
+    // at most -rewindmemory <MB>, 0 turning rewinding off. Rewinding would
+    // break a demo being recorded.
+    const auto rewind_memory{args.getInt("-rewindmemory").value_or(16)};
+    const auto can_rewind{!demo && !recorder && rewind_memory > 0};
+    const auto rewind_limit{static_cast<size_t>(std::max(rewind_memory, 0))};
+    RewindBuffer rewind_buffer{rewind_limit * 1024 * 1024, tic_rate};
+
+    // Run the next tic, or return false if the demo being played ended.
+    const auto runTic{[&] {
+        std::array<TicCmd, max_players> commands{};
+        const std::span tic_commands{commands.data(), num_players};
+        if (demo) {
+            if (game.getTic() == demo->getNumTics()) {
+                return false;
+            }
+            const auto demo_commands{demo->getTic(game.getTic())};
+            std::ranges::copy(demo_commands, commands.begin());
+        } else {
+            commands[0] = buildTicCmd();
+        }
+        if (recorder) {
+            recorder->record(tic_commands);
+        }
+        game.ticker(tic_commands);
+        if (demo) {
+            timeline.capture(game);
+        }
+        if (can_rewind) {
+            rewind_buffer.capture(game);
+        }
+        if (recorder) {
+            recorder->recordState(game);
+        }
+        if (desync_detector) {
+            desync_detector->check(game);
+        }
+        return true;
+    }};
 
-int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) {
-    WadManager wad_manager;
-    wad_manager.addWad("doom.wad");
+    // The first frame uploads the whole screen, later ones only the view
+    // and whatever changed in the status bar.
+    DirtyRegions dirty;
+    dirty.add({0, 0, frame.width, frame.height});
 
-    SDL_InitSubSystem(SDL_INIT_VIDEO);
-    Window window{};
+    // Headless runs are benchmarks: frames are not capped, the timing of
+    // each one is printed, and -frames <n> ends the run.
+    const auto max_frames{args.getInt("-frames")};
+    Uint64 frame_count{0};
 
     SDL_InitSubSystem(SDL_INIT_EVENTS);
+    const auto start_time{SDL_GetTicks()};
+    Sint64 tic_offset{0};
     auto quit{false};
     while (!quit) {
         SDL_Event event;
         while (SDL_PollEvent(&event)) {
             quit = (event.type == SDL_QUIT);
+            if (event.type != SDL_KEYDOWN) {
+                continue;
+            }
+            const auto key{event.key.keysym.sym};
+            if (key == SDLK_BACKSPACE && can_rewind) {
+                const auto tic{static_cast<Sint64>(game.getTic())};
+                rewind_buffer.rewind(game);
+                tic_offset += static_cast<Sint64>(game.getTic()) - tic;
+            }
+            // A quicksave that cannot be written or loaded leaves the game
+            // running as it was.
+            if (key == SDLK_F6 && !demo) {
+                try {
+                    Stopwatch save_time;
+                    saveGame(game, quicksave_file);
+                    std::cout << std::format(
+                        "Saved game in {:.2f} ms\n", save_time.lap()
+                    );
+                } catch (const std::exception& e) {
+                    std::cerr << std::format(
+                        "Could not save game: {}\n", e.what()
+                    );
+                }
+            }
+            if (key == SDLK_F9 && !demo && !recorder) {
+                try {
+                    Stopwatch load_time;
+                    const auto tic{static_cast<Sint64>(game.getTic())};
+                    readSaveGame(game, loadSaveGame(quicksave_file));
+                    rewind_buffer.clear();
+                    tic_offset += static_cast<Sint64>(game.getTic()) - tic;
+                    std::cout << std::format(
+                        "Loaded game in {:.2f} ms\n", load_time.lap()
+                    );
+                } catch (const std::exception& e) {
+                    std::cerr << std::format(
+                        "Could not load game: {}\n", e.what()
+                    );
+                }
+            }
+            if (!demo || timedemo_name) {
+                continue;
+            }
+            if (key == SDLK_PAGEUP || key == SDLK_PAGEDOWN) {
+                const auto tic{static_cast<Sint64>(game.getTic())};
+                const auto seek{key == SDLK_PAGEUP ? -seek_tics : seek_tics};
+                const auto target{std::max<Sint64>(tic + seek, 0)};
+                seekDemo(game, *demo, timeline, static_cast<Uint32>(target));
+                tic_offset += static_cast<Sint64>(game.getTic()) - tic;
+            }
+        }
+
+        // The game runs at 35 tics per second of real time, except in a
+        // timedemo, which runs one tic per frame.
+        Stopwatch stopwatch;
+        FrameTiming timing{};
+        const auto elapsed{SDL_GetTicks() - start_time};
+        const auto tic_target{
+            timedemo_name ? game.getTic() + 1
+                          : elapsed * tic_rate / 1000 + tic_offset
+        };
+        while (game.getTic() < tic_target) {
+            if (!runTic()) {
+                quit = true;
+                break;
+            }
+        }
+        timing.tic = stopwatch.lap();
+        if (quit) {
+            break;
+        }
+
+        renderer.renderFrame();
+        timing.render = stopwatch.lap();
+        timing.scratch = renderer.getScratchUsed();
+        timing.scratch_high_water = renderer.getScratchHighWater();
+        const auto& player{game.getConsolePlayer()};
+        const PlayerStatus player_status{
+            .health = player.health,
+            .armor = player.armor,
+            .ammo = player.ammo,
+        };
+        dirty.add(view_area);
+        status_bar.draw(player_status, dirty);
+        timing.hud = stopwatch.lap();
+        window.present(dirty.get());
+        dirty.clear();
+        timing.present = stopwatch.lap();
+
+        frame_count++;
+        if (max_frames && frame_count >= static_cast<Uint64>(*max_frames)) {
+            quit = true;
         }
-        SDL_Delay(16); // 60 FPS
+        if (timedemo_name) {
+            frame_stats.add(timing);
+        }
+        if (video_mode.headless) {
+            printFrameTiming(std::cout, frame_count, timing);
+        } else if (!timedemo_name) {
+            SDL_Delay(16); // 60 FPS
+        }
+    }
+
+    if (timedemo_name) {
+        frame_stats.printSummary(std::cout);
+        printSightStats(std::cout, game.getLevel().getSightStats());
+        if (csv_file) {
+            std::ofstream csv{std::filesystem::path{*csv_file}};
+            frame_stats.writeCsv(csv);
+        }
+    }
+    if (const auto& rewind_stats{rewind_buffer.getStats()};
+        rewind_stats.snapshots > 0) {
+        const auto snapshots{static_cast<double>(rewind_stats.snapshots)};
+        std::cout << std::format(
+            "rewind: {} snapshots, {} KB kept, last {} bytes, "
+            "{:.3f} ms average, {:.3f} ms max\n",
+            rewind_stats.snapshots,
+            rewind_stats.memory / 1024,
+            rewind_stats.last_size,
+            rewind_stats.total_time / snapshots,
+            rewind_stats.max_time
+        );
+    }
+    if (args.hasParam("-zonestats")) {
+        printZoneStats(std::cout, zone.getStats());
+    }
+    if (desync_detector && desync_detector->getDesyncTic()) {
+        std::cerr << std::format(
+            "Demo desynced after tic {}\n", *desync_detector->getDesyncTic()
+        );
     }
 
     return EXIT_SUCCESS;
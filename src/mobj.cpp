@@ -0,0 +1,17 @@
+#include "mobj.h"
+#include <cstdlib>
+
+void applyFriction(Mobj& mobj) {
+    // Nothing slows down missiles or mobjs in the air.
+    if ((mobj.flags & mf_missile) || mobj.z > mobj.floor_z) {
+        return;
+    }
+    if (std::abs(mobj.mom_x) < stop_speed
+        && std::abs(mobj.mom_y) < stop_speed) {
+        mobj.mom_x = 0;
+        mobj.mom_y = 0;
+        return;
+    }
+    mobj.mom_x = fixedMul(mobj.mom_x, friction);
+    mobj.mom_y = fixedMul(mobj.mom_y, friction);
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <SDL.h>
+#include "fixed.h"
+#include "pool.h"
+#include "tables.h"
+
+struct Mobj;
+struct Sector;
+
+using MobjHandle = Handle<Mobj>;
+
+// Mobj flags, with the values of the original.
+static constexpr Uint32 mf_special{0x1};
+static constexpr Uint32 mf_solid{0x2};
+static constexpr Uint32 mf_shootable{0x4};
+static constexpr Uint32 mf_no_blockmap{0x10};
+static constexpr Uint32 mf_dropoff{0x400};
+static constexpr Uint32 mf_no_clip{0x1000};
+static constexpr Uint32 mf_float{0x4000};
+static constexpr Uint32 mf_teleport{0x8000};
+static constexpr Uint32 mf_missile{0x10000};
+
+// Mobj that is not in a grid.
+static constexpr Uint32 no_grid_slot{0xffffffff};
+
+enum class ThinkerKind : Uint8 {
+    Mobj,
+};
+
+/**
+ * Anything that runs every tic. Thinkers are kept in a circular list,
+ * in the order they were added, which is the order they run in.
+ */
+struct Thinker {
+    Thinker* prev{nullptr};
+    Thinker* next{nullptr};
+    ThinkerKind kind;
+    // Removed while the thinkers run, and freed once they all did.
+    bool removed{false};
+};
+
+/**
+ * A map object: a monster, item, decoration or projectile.
+ */
+struct Mobj : Thinker {
+    // Slot of the mobj in its level's storage, by which savegames
+    // refer to it.
+    Uint32 id{};
+    int type{};
+    fixed_t x{};
+    fixed_t y{};
+    fixed_t z{};
+    angle_t angle{};
+    fixed_t mom_x{};
+    fixed_t mom_y{};
+    fixed_t mom_z{};
+    fixed_t radius{};
+    fixed_t height{};
+    // Floor and ceiling heights where the mobj stands, taking in every
+    // line it touches.
+    fixed_t floor_z{};
+    fixed_t ceiling_z{};
+    Uint32 flags{};
+    int health{};
+    // Tics left in the current state, or -1 to stay in it forever.
+    int tics{-1};
+    Sector* sector{nullptr};
+    // Mobjs in the same blockmap block.
+    Mobj* block_next{nullptr};
+    Mobj* block_prev{nullptr};
+    // Place of the mobj in the level's MobjGrid, if it has one.
+    Uint32 grid_slot{no_grid_slot};
+    // Mobj being chased or attacked, and the one a missile homes in on.
+    // Handles stop resolving once the mobj is removed.
+    MobjHandle target{};
+    MobjHandle tracer{};
+
+    Mobj()
+        : Thinker{.kind = ThinkerKind::Mobj} {
+    }
+};
+
+/**
+ * Circular list of thinkers around a sentinel, which is why it can be
+ * neither copied nor moved.
+ */
+class ThinkerList {
+    Thinker head{};
+
+  public:
+    ThinkerList() {
+        head.prev = &head;
+        head.next = &head;
+    }
+
+    ThinkerList(ThinkerList& other) = delete;
+    ThinkerList& operator=(const ThinkerList& other) = delete;
+
+    void add(Thinker* thinker) {
+        thinker->prev = head.prev;
+        thinker->next = &head;
+        head.prev->next = thinker;
+        head.prev = thinker;
+    }
+
+    void remove(Thinker* thinker) {
+        thinker->prev->next = thinker->next;
+        thinker->next->prev = thinker->prev;
+        thinker->prev = nullptr;
+        thinker->next = nullptr;
+    }
+
+    void clear() {
+        head.prev = &head;
+        head.next = &head;
+    }
+
+    // Call think(thinker) on every thinker, which may remove itself but
+    // no other thinker.
+    template <typename Think>
+    void forEach(Think think) const {
+        for (auto thinker{head.next}; thinker != &head;) {
+            const auto next{thinker->next};
+            think(thinker);
+            thinker = next;
+        }
+    }
+};
+
+// Speed below which a mobj or player on the ground stops, and factor
+// that slows it down every tic otherwise.
+static constexpr fixed_t stop_speed{0x1000};
+static constexpr fixed_t friction{0xe800};
+
+// Slow the mobj down by friction, stopping it once it is slow enough.
+void applyFriction(Mobj& mobj);
@@ -0,0 +1,188 @@
+#include "mobjgrid.h"
+#include <algorithm>
+
+// Marks the slots of pending mobjs, which index the pending list.
+static constexpr Uint32 pending_slot{0x80000000};
+
+// Cells along each side of a block, as a shift.
+static constexpr int cells_per_block_shift{map_block_shift - grid_cell_shift};
+
+// Radius of holes, which no query range reaches.
+static constexpr fixed_t hole_radius{-fixed_max};
+
+
+MobjGrid::MobjGrid(const Blockmap& blockmap)
+    : origin_x{blockmap.getOriginX()}
+    , origin_y{blockmap.getOriginY()}
+    , width{std::max(blockmap.getWidth() << cells_per_block_shift, 1)}
+    , height{std::max(blockmap.getHeight() << cells_per_block_shift, 1)}
+    , cell_starts(static_cast<size_t>(width) * height + 1) {
+}
+
+int MobjGrid::cellX(const fixed_t x) const {
+    return std::clamp((x - origin_x) >> grid_cell_shift, 0, width - 1);
+}
+
+int MobjGrid::cellY(const fixed_t y) const {
+    return std::clamp((y - origin_y) >> grid_cell_shift, 0, height - 1);
+}
+
+int MobjGrid::cellOf(const fixed_t x, const fixed_t y) const {
+    return cellY(y) * width + cellX(x);
+}
+
+void MobjGrid::addPending(Mobj& mobj) {
+    mobj.grid_slot = pending_slot | static_cast<Uint32>(pending.size());
+    pending.push_back(&mobj);
+    dirty = true;
+}
+
+void MobjGrid::removePending(Mobj& mobj) {
+    // The last pending mobj takes the place of the one removed. Queries
+    // return pending mobjs in list order, which stays the same for the
+    // same moves, so games still play out the same every time.
+    const auto index{mobj.grid_slot & ~pending_slot};
+    const auto last{pending.back()};
+    pending[index] = last;
+    last->grid_slot = pending_slot | index;
+    pending.pop_back();
+}
+
+void MobjGrid::link(Mobj& mobj) {
+    if (mobj.flags & mf_no_blockmap) {
+        unlink(mobj);
+        return;
+    }
+    const auto slot{mobj.grid_slot};
+    if (slot == no_grid_slot) {
+        addPending(mobj);
+        return;
+    }
+    // Queries read where pending mobjs are from the mobjs themselves.
+    if (slot & pending_slot) {
+        return;
+    }
+    if (cellOf(xs[slot], ys[slot]) == cellOf(mobj.x, mobj.y)) {
+        xs[slot] = mobj.x;
+        ys[slot] = mobj.y;
+        radii[slot] = mobj.radius;
+        return;
+    }
+    cell_mobjs[slot] = nullptr;
+    radii[slot] = hole_radius;
+    addPending(mobj);
+}
+
+void MobjGrid::unlink(Mobj& mobj) {
+    const auto slot{mobj.grid_slot};
+    if (slot == no_grid_slot) {
+        return;
+    }
+    if (slot & pending_slot) {
+        removePending(mobj);
+    } else {
+        cell_mobjs[slot] = nullptr;
+        radii[slot] = hole_radius;
+        dirty = true;
+    }
+    mobj.grid_slot = no_grid_slot;
+}
+
+void MobjGrid::clear() {
+    std::ranges::fill(cell_starts, 0);
+    cell_mobjs.clear();
+    xs.clear();
+    ys.clear();
+    radii.clear();
+    pending.clear();
+    dirty = false;
+}
+
+void MobjGrid::update() {
+    if (!dirty) {
+        return;
+    }
+
+    // Mobjs keep their order within a cell, and pending mobjs go after
+    // the ones that were already there.
+    sorting.clear();
+    sorting_cells.clear();
+    const auto add{[&](Mobj* mobj) {
+        sorting.push_back(mobj);
+        sorting_cells.push_back(cellOf(mobj->x, mobj->y));
+    }};
+    for (const auto mobj : cell_mobjs) {
+        if (mobj) {
+            add(mobj);
+        }
+    }
+    for (const auto mobj : pending) {
+        add(mobj);
+    }
+    pending.clear();
+
+    std::ranges::fill(cell_starts, 0);
+    for (const auto cell : sorting_cells) {
+        cell_starts[cell + 1]++;
+    }
+    for (size_t cell = 1; cell < cell_starts.size(); cell++) {
+        cell_starts[cell] += cell_starts[cell - 1];
+    }
+    const auto count{sorting.size()};
+    cell_mobjs.resize(count);
+    xs.resize(count);
+    ys.resize(count);
+    radii.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        // Each start moves along as its cell fills, ending up at the
+        // start of the next cell, so the starts are shifted back after.
+        const auto slot{cell_starts[sorting_cells[i]]++};
+        const auto mobj{sorting[i]};
+        cell_mobjs[slot] = mobj;
+        xs[slot] = mobj->x;
+        ys[slot] = mobj->y;
+        radii[slot] = mobj->radius;
+        mobj->grid_slot = slot;
+    }
+    std::shift_right(cell_starts.begin(), cell_starts.end(), 1);
+    cell_starts[0] = 0;
+    dirty = false;
+}
+
+std::span<Mobj* const> MobjGrid::query(
+    const fixed_t x,
+    const fixed_t y,
+    const fixed_t range
+) {
+    found.clear();
+    const auto reach{range + max_radius};
+    const auto left{cellX(x - reach)};
+    const auto right{cellX(x + reach)};
+    const auto bottom{cellY(y - reach)};
+    const auto top{cellY(y + reach)};
+
+    // The cells of a row are next to each other, so their mobjs are
+    // tested in one pass, appending every one and keeping those that
+    // pass. Holes never pass.
+    for (auto row{bottom}; row <= top; row++) {
+        const auto start{cell_starts[row * width + left]};
+        const auto stop{cell_starts[row * width + right + 1]};
+        auto count{found.size()};
+        found.resize(count + (stop - start));
+        for (auto i{start}; i < stop; i++) {
+            const auto mobj_reach{range + radii[i]};
+            found[count] = cell_mobjs[i];
+            count += (std::abs(xs[i] - x) < mobj_reach)
+                     & (std::abs(ys[i] - y) < mobj_reach);
+        }
+        found.resize(count);
+    }
+    for (const auto mobj : pending) {
+        const auto mobj_reach{range + mobj->radius};
+        if (std::abs(mobj->x - x) < mobj_reach
+            && std::abs(mobj->y - y) < mobj_reach) {
+            found.push_back(mobj);
+        }
+    }
+    return found;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <SDL.h>
+#include <cstdlib>
+#include <span>
+#include <vector>
+#include "blockmap.h"
+#include "fixed.h"
+#include "mobj.h"
+
+// Cells of the grid are 64 map units square, a quarter of a block.
+static constexpr int grid_cell_shift{frac_bits + 6};
+
+/**
+ * Mobjs sorted by the grid cell of their center, an alternative to the
+ * thing links of the blockmap for crowded maps. The mobjs of all cells
+ * are packed into arrays in cell order, along with copies of their
+ * positions and radii, so that a query scans each row of cells it
+ * covers as one contiguous range instead of following links from mobj
+ * to mobj.
+ *
+ * Mobjs that move within their cell are updated in place. The rest of
+ * the changes are batched: mobjs that spawn or move to another cell are
+ * kept in a short list that every query also scans, and mobjs that go
+ * leave a hole, until update() sorts everything again at the start of
+ * the next tic.
+ */
+class MobjGrid {
+    fixed_t origin_x{};
+    fixed_t origin_y{};
+    int width{1};
+    int height{1};
+
+    // Mobjs of cell c are at [cell_starts[c], cell_starts[c + 1]) in
+    // the arrays below, null where a mobj left.
+    std::vector<Uint32> cell_starts{};
+    std::vector<Mobj*> cell_mobjs{};
+    std::vector<fixed_t> xs{};
+    std::vector<fixed_t> ys{};
+    std::vector<fixed_t> radii{};
+
+    // Mobjs spawned or moved to another cell since the last update.
+    std::vector<Mobj*> pending{};
+    bool dirty{false};
+
+    // Mobjs being sorted by update(), and their cells.
+    std::vector<Mobj*> sorting{};
+    std::vector<Uint32> sorting_cells{};
+
+    // Result of the last query.
+    std::vector<Mobj*> found{};
+
+    [[nodiscard]]
+    int cellX(fixed_t x) const;
+
+    [[nodiscard]]
+    int cellY(fixed_t y) const;
+
+    [[nodiscard]]
+    int cellOf(fixed_t x, fixed_t y) const;
+
+    void addPending(Mobj& mobj);
+    void removePending(Mobj& mobj);
+
+  public:
+    // Grid over the area of the blockmap. The level links only the mobjs
+    // that are in a block, and queries beyond the edges look in the
+    // cells along them.
+    explicit MobjGrid(const Blockmap& blockmap);
+
+    MobjGrid(MobjGrid& other) = delete;
+    MobjGrid& operator=(const MobjGrid& other) = delete;
+
+    // Add the mobj, or follow it to where it moved.
+    void link(Mobj& mobj);
+
+    void unlink(Mobj& mobj);
+
+    // Forget every mobj, when they are all freed at once.
+    void clear();
+
+    // Sort the mobjs that moved to other cells into them.
+    void update();
+
+    /**
+     * Mobjs whose bounding box comes closer to (x, y) than range along
+     * both axes, in cell order. The span is valid until the next query.
+     */
+    std::span<Mobj* const> query(fixed_t x, fixed_t y, fixed_t range);
+
+    /**
+     * Call check(mobj) on the mobjs query() would find, as long as it
+     * returns true, and return whether it always did. Collision checks
+     * mostly stop at the first mobj in the way, so this tests one mobj
+     * at a time instead of collecting them all first.
+     */
+    template <typename Check>
+    bool checkNear(fixed_t x, fixed_t y, fixed_t range, Check check) const;
+};
+
+template <typename Check>
+bool MobjGrid::checkNear(
+    const fixed_t x,
+    const fixed_t y,
+    const fixed_t range,
+    Check check
+) const {
+    const auto reach{range + max_radius};
+    const auto left{cellX(x - reach)};
+    const auto right{cellX(x + reach)};
+    const auto bottom{cellY(y - reach)};
+    const auto top{cellY(y + reach)};
+    for (auto row{bottom}; row <= top; row++) {
+        const auto stop{cell_starts[row * width + right + 1]};
+        for (auto i{cell_starts[row * width + left]}; i < stop; i++) {
+            const auto mobj_reach{range + radii[i]};
+            if (std::abs(xs[i] - x) < mobj_reach
+                && std::abs(ys[i] - y) < mobj_reach
+                && !check(*cell_mobjs[i])) {
+                return false;
+            }
+        }
+    }
+    for (const auto mobj : pending) {
+        const auto mobj_reach{range + mobj->radius};
+        if (std::abs(mobj->x - x) < mobj_reach
+            && std::abs(mobj->y - y) < mobj_reach
+            && !check(*mobj)) {
+            return false;
+        }
+    }
+    return true;
+}
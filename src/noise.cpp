@@ -0,0 +1,78 @@
+#include "noise.h"
+#include <algorithm>
+#include "level.h"
+
+
+// Whether noise gets from one sector to the other, which it does unless
+// the lines between them are closed like shut doors.
+static bool isOpen(const Sector& from, const Sector& to) {
+    const auto top{std::min(from.ceiling_height, to.ceiling_height)};
+    const auto bottom{std::max(from.floor_height, to.floor_height)};
+    return top > bottom;
+}
+
+// The original recursed through the sectors, revisiting a sector when
+// it got there through fewer sound blocking lines, which deep maps could
+// overflow the stack with. The flood here goes breadth first in two
+// passes over queues instead: first through the sectors the noise
+// reaches without crossing a sound blocking line, then through those it
+// only reaches across one. Every sector ends up with the same target and
+// count of lines crossed as in the original, having been queued at most
+// once per pass.
+void noiseAlert(Level& level, const MobjHandle target, const Sector& emitter) {
+    const auto stamp{level.newSoundCount()};
+    const auto sectors{level.getSectors()};
+    const auto queues{level.getSoundQueues()};
+    const auto open_queue{queues.first(sectors.size())};
+    const auto blocked_queue{queues.last(sectors.size())};
+    size_t num_open{0};
+    size_t num_blocked{0};
+
+    // Reach the sector through sound_blocks lines, unless the noise got
+    // there through as few already.
+    const auto reach{[&](const Uint32 index, const int sound_blocks) {
+        auto& sector{sectors[index]};
+        if (sector.sound_stamp == stamp
+            && sector.sound_traversed <= sound_blocks + 1) {
+            return false;
+        }
+        sector.sound_stamp = stamp;
+        sector.sound_traversed = sound_blocks + 1;
+        sector.sound_target = target;
+        return true;
+    }};
+
+    const auto first{level.sectorIndex(emitter)};
+    reach(first, 0);
+    open_queue[num_open++] = first;
+    for (size_t i = 0; i < num_open; i++) {
+        const auto& sector{sectors[open_queue[i]]};
+        for (const auto& link : level.getSectorLinks(open_queue[i])) {
+            if (!isOpen(sector, sectors[link.sector])) {
+                continue;
+            }
+            if (!link.sound_block) {
+                if (reach(link.sector, 0)) {
+                    open_queue[num_open++] = link.sector;
+                }
+            } else if (reach(link.sector, 1)) {
+                blocked_queue[num_blocked++] = link.sector;
+            }
+        }
+    }
+
+    // Sectors the first pass got to in the end are skipped.
+    for (size_t i = 0; i < num_blocked; i++) {
+        const auto& sector{sectors[blocked_queue[i]]};
+        if (sector.sound_traversed != 2) {
+            continue;
+        }
+        for (const auto& link : level.getSectorLinks(blocked_queue[i])) {
+            if (!link.sound_block
+                && isOpen(sector, sectors[link.sector])
+                && reach(link.sector, 1)) {
+                blocked_queue[num_blocked++] = link.sector;
+            }
+        }
+    }
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "mobj.h"
+
+class Level;
+struct Sector;
+
+/**
+ * Let every sector that hears a noise made in the emitter's sector know
+ * that the target made it, as the original P_NoiseAlert. Noise floods
+ * through the two-sided lines that are open, and through at most one
+ * line that blocks sound.
+ */
+void noiseAlert(Level& level, MobjHandle target, const Sector& emitter);
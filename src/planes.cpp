@@ -0,0 +1,147 @@
+#include "planes.h"
+#include <algorithm>
+
+// Buckets of the plane hash, doubled whenever planes outnumber them.
+static constexpr size_t initial_buckets{128};
+
+
+static size_t hashPlane(
+    const fixed_t height,
+    const int picnum,
+    const int light_level
+) {
+    auto hash{static_cast<Uint32>(height) * 0x9e3779b1u};
+    hash ^= static_cast<Uint32>(picnum) * 0x85ebca6bu;
+    hash ^= static_cast<Uint32>(light_level) * 0xc2b2ae35u;
+    return hash ^ (hash >> 16);
+}
+
+VisplaneSet::VisplaneSet()
+    : num_buckets{initial_buckets} {
+}
+
+void VisplaneSet::clear(
+    ZoneArena& frame_arena,
+    const int start,
+    const int stop,
+    const int view_height
+) {
+    arena = &frame_arena;
+    planes.clear(frame_arena);
+    buckets = frame_arena.allocateArray<Visplane*>(num_buckets);
+    span_start = frame_arena.allocate<int>(view_height);
+    first_x = start;
+    last_x = stop - 1;
+}
+
+Visplane* VisplaneSet::newPlane(
+    const fixed_t height,
+    const int picnum,
+    const int light_level
+) {
+    const auto width{static_cast<size_t>(last_x - first_x + 1)};
+    const auto plane{arena->allocate<Visplane>(1)};
+    plane->height = height;
+    plane->picnum = picnum;
+    plane->light_level = light_level;
+    plane->min_x = last_x + 1;
+    plane->max_x = first_x - 1;
+    plane->hash_next = nullptr;
+    plane->tops = arena->allocate<Uint16>(width + 2);
+    plane->bottoms = arena->allocate<Uint16>(width + 2);
+    plane->origin = first_x;
+    std::fill_n(plane->tops, width + 2, unused_row);
+    std::fill_n(plane->bottoms, width + 2, Uint16{0});
+    planes.push_back(plane);
+    return plane;
+}
+
+void VisplaneSet::rehash() {
+    // The planes are moved over to twice as many buckets, and the old
+    // buckets left to the frame arena.
+    const auto old_buckets{buckets};
+    buckets = arena->allocateArray<Visplane*>(old_buckets.size() * 2);
+    num_buckets = buckets.size();
+    const auto mask{buckets.size() - 1};
+    for (auto plane : old_buckets) {
+        while (plane) {
+            const auto next{plane->hash_next};
+            auto& bucket{buckets[hashPlane(
+                plane->height, plane->picnum, plane->light_level
+            ) & mask]};
+            plane->hash_next = bucket;
+            bucket = plane;
+            plane = next;
+        }
+    }
+}
+
+Visplane* VisplaneSet::findPlane(
+    const fixed_t height,
+    const int picnum,
+    const int light_level
+) {
+    const auto hash{hashPlane(height, picnum, light_level)};
+    auto bucket{&buckets[hash & (buckets.size() - 1)]};
+    for (auto plane{*bucket}; plane; plane = plane->hash_next) {
+        if (plane->height == height
+            && plane->picnum == picnum
+            && plane->light_level == light_level) {
+            return plane;
+        }
+    }
+
+    if (planes.size() >= buckets.size()) {
+        rehash();
+        bucket = &buckets[hash & (buckets.size() - 1)];
+    }
+    const auto plane{newPlane(height, picnum, light_level)};
+    plane->hash_next = *bucket;
+    *bucket = plane;
+    return plane;
+}
+
+Visplane* VisplaneSet::checkPlane(
+    Visplane* plane,
+    const int start,
+    const int stop
+) {
+    int intersect_low{};
+    int intersect_high{};
+    int union_low{};
+    int union_high{};
+    if (start < plane->min_x) {
+        intersect_low = plane->min_x;
+        union_low = start;
+    } else {
+        union_low = plane->min_x;
+        intersect_low = start;
+    }
+    if (stop > plane->max_x) {
+        intersect_high = plane->max_x;
+        union_high = stop;
+    } else {
+        union_high = plane->max_x;
+        intersect_high = stop;
+    }
+
+    auto x{intersect_low};
+    while (x <= intersect_high && plane->top(x) == unused_row) {
+        x++;
+    }
+    if (x > intersect_high) {
+        plane->min_x = union_low;
+        plane->max_x = union_high;
+        return plane;
+    }
+
+    // The columns are taken, start a new plane for the same surface. It
+    // stays out of the hash: lookups return the oldest plane of a
+    // surface, as the original linear search did.
+    const auto split{
+        newPlane(plane->height, plane->picnum, plane->light_level)
+    };
+    split->min_x = start;
+    split->max_x = stop;
+    return split;
+}
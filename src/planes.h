@@ -0,0 +1,147 @@
+#pragma once
+
+#include <SDL.h>
+#include <span>
+#include "fixed.h"
+#include "zone.h"
+
+/**
+ * Floor or ceiling area of the view sharing the same height, flat and
+ * light level. For every column the plane records the first and last
+ * row it covers, which are turned into horizontal spans once the walls
+ * of the frame are done.
+ */
+struct Visplane {
+    fixed_t height;
+    int picnum;
+    int light_level;
+
+    // Columns covered so far, empty while min_x > max_x.
+    int min_x;
+    int max_x;
+
+    // Next plane in the same hash bucket.
+    Visplane* hash_next;
+
+    // Rows of the columns in [origin, origin + width), with one guard
+    // entry on each side. Unused columns have a top of unused_row.
+    Uint16* tops;
+    Uint16* bottoms;
+    int origin;
+
+    Uint16& top(const int x) {
+        return tops[x - origin + 1];
+    }
+
+    Uint16& bottom(const int x) {
+        return bottoms[x - origin + 1];
+    }
+};
+
+/**
+ * The visplanes of a frame, or of one strip of it. Planes are merged
+ * through a hash on (height, picnum, light level) instead of a linear
+ * search, their number is only limited by memory, and all of their
+ * storage comes from the frame arena.
+ */
+class VisplaneSet {
+    ZoneArena* arena{nullptr};
+    ArenaVector<Visplane*> planes{};
+    // Buckets of the plane hash, in the frame arena. Frames start with
+    // as many as the last one grew to.
+    std::span<Visplane*> buckets{};
+    size_t num_buckets;
+    int* span_start{nullptr};
+    int first_x{};
+    int last_x{};
+
+    Visplane* newPlane(fixed_t height, int picnum, int light_level);
+    void rehash();
+
+    template <typename MapSpan>
+    void makeSpans(
+        const Visplane& plane, int x, int t1, int b1, int t2, int b2,
+        MapSpan& map_span
+    );
+
+  public:
+    VisplaneSet();
+
+    // Forget every plane and prepare for a frame covering the columns
+    // [start, stop) of a view of the given height, allocated in the
+    // arena of the frame.
+    void clear(ZoneArena& frame_arena, int start, int stop, int view_height);
+
+    [[nodiscard]]
+    size_t size() const {
+        return planes.size();
+    }
+
+    // Planes in the order they were made, which drawPlanes() goes in.
+    [[nodiscard]]
+    std::span<Visplane* const> getPlanes() const {
+        return {planes.data(), planes.size()};
+    }
+
+    // Plane the given surface is merged into, created if needed. Sky
+    // surfaces should be passed with a height and light level of 0.
+    Visplane* findPlane(fixed_t height, int picnum, int light_level);
+
+    // Plane to extend with the columns [start, stop]: the given plane
+    // if none of them is in use yet, a new plane with the same surface
+    // otherwise.
+    Visplane* checkPlane(Visplane* plane, int start, int stop);
+
+    // Turn every plane into spans, calling map_span(plane, y, x1, x2)
+    // for each of them.
+    template <typename MapSpan>
+    void drawPlanes(MapSpan&& map_span);
+};
+
+static constexpr Uint16 unused_row{0xffff};
+
+template <typename MapSpan>
+void VisplaneSet::makeSpans(
+    const Visplane& plane,
+    const int x,
+    int t1,
+    int b1,
+    int t2,
+    int b2,
+    MapSpan& map_span
+) {
+    // Close the spans of the rows the previous column covered but this
+    // one does not, and open those this column starts covering.
+    for (; t1 < t2 && t1 <= b1; t1++) {
+        map_span(plane, t1, span_start[t1], x - 1);
+    }
+    for (; b1 > b2 && b1 >= t1; b1--) {
+        map_span(plane, b1, span_start[b1], x - 1);
+    }
+    for (; t2 < t1 && t2 <= b2; t2++) {
+        span_start[t2] = x;
+    }
+    for (; b2 > b1 && b2 >= t2; b2--) {
+        span_start[b2] = x;
+    }
+}
+
+template <typename MapSpan>
+void VisplaneSet::drawPlanes(MapSpan&& map_span) {
+    for (const auto plane : planes) {
+        if (plane->min_x > plane->max_x) {
+            continue;
+        }
+        plane->top(plane->min_x - 1) = unused_row;
+        plane->top(plane->max_x + 1) = unused_row;
+        const auto stop{plane->max_x + 1};
+        for (auto x = plane->min_x; x <= stop; x++) {
+            makeSpans(
+                *plane, x,
+                plane->top(x - 1), plane->bottom(x - 1),
+                plane->top(x), plane->bottom(x),
+                map_span
+            );
+        }
+    }
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <SDL.h>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+
+/**
+ * Reference to an object in a SlabPool. The handle remembers the
+ * generation of the slot it refers to, so that it stops resolving once
+ * the object is freed, even if the slot is reused.
+ */
+template <typename T>
+struct Handle {
+    static constexpr Uint32 invalid_index{std::numeric_limits<Uint32>::max()};
+
+    Uint32 index{invalid_index};
+    Uint32 generation{0};
+
+    [[nodiscard]]
+    bool isNull() const {
+        return index == invalid_index;
+    }
+
+    friend bool operator==(const Handle& a, const Handle& b) = default;
+};
+
+/**
+ * Pool of objects of a single type, stored in fixed-size chunks so that
+ * they never move and allocating them rarely touches the heap. Freed
+ * slots are reused lowest first, which keeps live objects packed towards
+ * the front and makes the slot an object gets depend only on which slots
+ * are live, so that a pool rebuilt from a savegame allocates just like
+ * the one it was saved from.
+ */
+template <typename T, Uint32 ChunkSize = 256>
+class SlabPool {
+    struct Slot {
+        T object{};
+        Uint32 generation{0};
+        bool live{false};
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> chunks{};
+    // Min-heap of free slots.
+    std::vector<Uint32> free_slots{};
+    Uint32 num_slots{0};
+    Uint32 num_live{0};
+
+    Slot& slot(const Uint32 index) const {
+        return chunks[index / ChunkSize][index % ChunkSize];
+    }
+
+    // Slots beyond the end keep their generations from before a reset(),
+    // so that old handles to them never resolve again.
+    Uint32 addSlots(const Uint32 count) {
+        const auto first{num_slots};
+        num_slots += count;
+        while (chunks.size() * ChunkSize < num_slots) {
+            chunks.push_back(std::make_unique<Slot[]>(ChunkSize));
+        }
+        return first;
+    }
+
+  public:
+    // Slots allocated so far, live or free.
+    [[nodiscard]]
+    Uint32 numSlots() const {
+        return num_slots;
+    }
+
+    [[nodiscard]]
+    Uint32 size() const {
+        return num_live;
+    }
+
+    // Allocate a value-initialized object.
+    Handle<T> allocate() {
+        Uint32 index{};
+        if (free_slots.empty()) {
+            index = addSlots(1);
+        } else {
+            std::ranges::pop_heap(free_slots, std::greater{});
+            index = free_slots.back();
+            free_slots.pop_back();
+        }
+        return allocateAt(index);
+    }
+
+    // Free the object, which every handle to it stops resolving to.
+    void free(const Handle<T> handle) {
+        if (!get(handle)) {
+            return;
+        }
+        auto& freed{slot(handle.index)};
+        freed.live = false;
+        freed.generation++;
+        free_slots.push_back(handle.index);
+        std::ranges::push_heap(free_slots, std::greater{});
+        num_live--;
+    }
+
+    // The object, or null if it was freed.
+    [[nodiscard]]
+    T* get(const Handle<T> handle) const {
+        if (handle.index >= num_slots) {
+            return nullptr;
+        }
+        auto& found{slot(handle.index)};
+        if (!found.live || found.generation != handle.generation) {
+            return nullptr;
+        }
+        return &found.object;
+    }
+
+    [[nodiscard]]
+    T& at(const Uint32 index) const {
+        return slot(index).object;
+    }
+
+    [[nodiscard]]
+    Handle<T> handleOf(const Uint32 index) const {
+        return {index, slot(index).generation};
+    }
+
+    /**
+     * Free every object and make the pool num_slots slots long, to then
+     * allocate objects at given slots with allocateAt(). Handles from
+     * before stay invalid.
+     */
+    void reset(const Uint32 slots) {
+        for (Uint32 index = 0; index < num_slots; index++) {
+            auto& reset_slot{slot(index)};
+            if (reset_slot.live) {
+                reset_slot.live = false;
+                reset_slot.generation++;
+            }
+        }
+        num_live = 0;
+        free_slots.clear();
+        if (slots > num_slots) {
+            addSlots(slots - num_slots);
+        }
+        num_slots = slots;
+    }
+
+    // Allocate the object at a free slot.
+    Handle<T> allocateAt(const Uint32 index) {
+        auto& allocated{slot(index)};
+        allocated.object = T{};
+        allocated.live = true;
+        num_live++;
+        return {index, allocated.generation};
+    }
+
+    [[nodiscard]]
+    bool isLive(const Uint32 index) const {
+        return index < num_slots && slot(index).live;
+    }
+
+    // Rebuild the list of free slots after allocating with allocateAt().
+    void collectFreeSlots() {
+        // Ascending slots already make a min-heap.
+        free_slots.clear();
+        for (Uint32 index = 0; index < num_slots; index++) {
+            if (!slot(index).live) {
+                free_slots.push_back(index);
+            }
+        }
+    }
+
+    // Call f(object) on every live object, in memory order.
+    template <typename F>
+    void forEach(F f) const {
+        for (Uint32 index = 0; index < num_slots; index++) {
+            auto& visited{slot(index)};
+            if (visited.live) {
+                f(visited.object);
+            }
+        }
+    }
+};
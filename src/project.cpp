@@ -0,0 +1,170 @@
+#include "project.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PROJECT_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PROJECT_SSE2
+#endif
+
+
+static void transformPoint(
+    const ViewPoint& view,
+    const fixed_t x,
+    const fixed_t y,
+    fixed_t& tx,
+    fixed_t& tz
+) {
+    const auto tr_x{x - view.x};
+    const auto tr_y{y - view.y};
+    tz = fixedMul(tr_x, view.cos) + fixedMul(tr_y, view.sin);
+    tx = fixedMul(tr_x, view.sin) - fixedMul(tr_y, view.cos);
+}
+
+void transformPointsScalar(
+    const ViewPoint& view,
+    const std::span<const fixed_t> xs,
+    const std::span<const fixed_t> ys,
+    const std::span<fixed_t> txs,
+    const std::span<fixed_t> tzs
+) {
+    for (size_t i = 0; i < xs.size(); i++) {
+        transformPoint(view, xs[i], ys[i], txs[i], tzs[i]);
+    }
+}
+
+#if defined(PROJECT_AVX2) || defined(PROJECT_SSE2)
+#ifdef PROJECT_AVX2
+using FixedVector = __m256i;
+static constexpr size_t vector_lanes{8};
+
+static FixedVector load(const fixed_t* values) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values));
+}
+
+static void store(fixed_t* values, const FixedVector vector) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(values), vector);
+}
+
+static FixedVector broadcast(const fixed_t value) {
+    return _mm256_set1_epi32(value);
+}
+
+static FixedVector add(const FixedVector a, const FixedVector b) {
+    return _mm256_add_epi32(a, b);
+}
+
+static FixedVector subtract(const FixedVector a, const FixedVector b) {
+    return _mm256_sub_epi32(a, b);
+}
+
+// fixedMul of every lane: the 64-bit products of the even and the odd
+// lanes, shifted down and interleaved back.
+static FixedVector multiply(const FixedVector a, const FixedVector b) {
+    const auto even{_mm256_srli_epi64(_mm256_mul_epi32(a, b), frac_bits)};
+    const auto odd{_mm256_srli_epi64(
+        _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32)),
+        frac_bits
+    )};
+    return _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xaa);
+}
+#else
+using FixedVector = __m128i;
+static constexpr size_t vector_lanes{4};
+
+static FixedVector load(const fixed_t* values) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+}
+
+static void store(fixed_t* values, const FixedVector vector) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(values), vector);
+}
+
+static FixedVector broadcast(const fixed_t value) {
+    return _mm_set1_epi32(value);
+}
+
+static FixedVector add(const FixedVector a, const FixedVector b) {
+    return _mm_add_epi32(a, b);
+}
+
+static FixedVector subtract(const FixedVector a, const FixedVector b) {
+    return _mm_sub_epi32(a, b);
+}
+
+/**
+ * fixedMul of every lane. SSE2 only multiplies unsigned numbers, whose
+ * product differs from the signed one in the upper half: a negative a
+ * adds b to it and a negative b adds a. Only bits 16 to 47 of the
+ * product are kept, so subtracting those from the upper half is enough.
+ */
+static FixedVector multiply(const FixedVector a, const FixedVector b) {
+    const auto correction{_mm_add_epi32(
+        _mm_and_si128(_mm_srai_epi32(a, 31), b),
+        _mm_and_si128(_mm_srai_epi32(b, 31), a)
+    )};
+    const auto high_lanes{_mm_set_epi32(-1, 0, -1, 0)};
+    auto even{_mm_mul_epu32(a, b)};
+    even = _mm_sub_epi64(even, _mm_slli_epi64(correction, 32));
+    auto odd{_mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32))};
+    odd = _mm_sub_epi64(odd, _mm_and_si128(correction, high_lanes));
+    even = _mm_srli_epi64(even, frac_bits);
+    odd = _mm_srli_epi64(odd, frac_bits);
+    return _mm_or_si128(
+        _mm_andnot_si128(high_lanes, even),
+        _mm_slli_epi64(odd, 32)
+    );
+}
+#endif
+
+void transformPoints(
+    const ViewPoint& view,
+    const std::span<const fixed_t> xs,
+    const std::span<const fixed_t> ys,
+    const std::span<fixed_t> txs,
+    const std::span<fixed_t> tzs
+) {
+    const auto count{xs.size()};
+    const auto view_x{broadcast(view.x)};
+    const auto view_y{broadcast(view.y)};
+    const auto view_cos{broadcast(view.cos)};
+    const auto view_sin{broadcast(view.sin)};
+    size_t i{0};
+    for (; i + vector_lanes <= count; i += vector_lanes) {
+        const auto tr_x{subtract(load(&xs[i]), view_x)};
+        const auto tr_y{subtract(load(&ys[i]), view_y)};
+        const auto tz{add(multiply(tr_x, view_cos), multiply(tr_y, view_sin))};
+        const auto tx{
+            subtract(multiply(tr_x, view_sin), multiply(tr_y, view_cos))
+        };
+        store(&tzs[i], tz);
+        store(&txs[i], tx);
+    }
+    for (; i < count; i++) {
+        transformPoint(view, xs[i], ys[i], txs[i], tzs[i]);
+    }
+}
+#else
+void transformPoints(
+    const ViewPoint& view,
+    const std::span<const fixed_t> xs,
+    const std::span<const fixed_t> ys,
+    const std::span<fixed_t> txs,
+    const std::span<fixed_t> tzs
+) {
+    transformPointsScalar(view, xs, ys, txs, tzs);
+}
+#endif
+
+void projectScales(
+    const fixed_t projection,
+    const std::span<const fixed_t> tzs,
+    const std::span<fixed_t> scales
+) {
+    // Integer division has no vector instruction, but the loop has no
+    // dependencies between iterations, so the divisions overlap.
+    for (size_t i = 0; i < tzs.size(); i++) {
+        scales[i] = fixedDiv(projection, tzs[i]);
+    }
+}
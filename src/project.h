@@ -0,0 +1,51 @@
+#pragma once
+
+#include <SDL.h>
+#include <span>
+#include "fixed.h"
+#include "tables.h"
+
+// Position and direction of the view.
+struct ViewPoint {
+    fixed_t x;
+    fixed_t y;
+    fixed_t cos;
+    fixed_t sin;
+
+    ViewPoint(const fixed_t x, const fixed_t y, const angle_t angle)
+        : x{x}
+        , y{y}
+        , cos{fineCosine(angle)}
+        , sin{fineSine(angle)} {
+    }
+};
+
+/**
+ * Move map points into view space as the original sprite projection
+ * does: tz is the depth along the view direction and tx the distance to
+ * the right of it. The points are done several at a time in vector
+ * registers, with the same results as one at a time.
+ */
+void transformPoints(
+    const ViewPoint& view,
+    std::span<const fixed_t> xs,
+    std::span<const fixed_t> ys,
+    std::span<fixed_t> txs,
+    std::span<fixed_t> tzs
+);
+
+// transformPoints() one point at a time, to check the vectorized one.
+void transformPointsScalar(
+    const ViewPoint& view,
+    std::span<const fixed_t> xs,
+    std::span<const fixed_t> ys,
+    std::span<fixed_t> txs,
+    std::span<fixed_t> tzs
+);
+
+// Scale of each depth, projection / tz.
+void projectScales(
+    fixed_t projection,
+    std::span<const fixed_t> tzs,
+    std::span<fixed_t> scales
+);
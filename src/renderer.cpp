@@ -0,0 +1,136 @@
+#include "renderer.h"
+#include <algorithm>
+#include <chrono>
+
+using std::vector;
+
+// Narrowest strip the balancing may produce, in columns.
+static constexpr int min_strip_width{16};
+
+
+ViewStrip::ViewStrip(
+    const int start,
+    const int stop,
+    const int view_width,
+    Zone& zone
+)
+    : start{start}
+    , stop{stop}
+    , ceiling_clip(view_width)
+    , floor_clip(view_width)
+    , arena{zone} {
+}
+
+static int countStrips(const FrameBuffer& frame, const WorkerGroup& workers) {
+    const auto max_strips{static_cast<size_t>(frame.width / min_strip_width)};
+    return static_cast<int>(std::min(workers.size(), max_strips));
+}
+
+Renderer::Renderer(
+    const FrameBuffer& frame,
+    WorkerGroup& workers,
+    Zone& zone
+)
+    : frame{frame}
+    , drawer{frame}
+    , workers{workers} {
+    const auto num_strips{countStrips(frame, workers)};
+    strips.reserve(num_strips);
+    for (int i = 0; i < num_strips; i++) {
+        const auto start{frame.width * i / num_strips};
+        const auto stop{frame.width * (i + 1) / num_strips};
+        strips.emplace_back(start, stop, frame.width, zone);
+    }
+}
+
+void Renderer::renderStrip(ViewStrip& strip) const {
+    const auto view_height{static_cast<short>(frame.height)};
+    for (int x = strip.start; x < strip.stop; x++) {
+        strip.ceiling_clip[x] = -1;
+        strip.floor_clip[x] = view_height;
+    }
+    auto& frame_arena{strip.arena.beginFrame()};
+    strip.planes.clear(frame_arena, strip.start, strip.stop, frame.height);
+    strip.drawsegs.clear(frame_arena);
+    strip.sprites.clear(frame_arena);
+    if (column_work) {
+        for (int x = strip.start; x < strip.stop; x++) {
+            column_work(drawer, x);
+        }
+    }
+}
+
+void Renderer::balanceStrips() {
+    const auto num_strips{strips.size()};
+    if (num_strips < 2) {
+        return;
+    }
+    double total_time{};
+    for (const auto& strip : strips) {
+        total_time += strip.render_time;
+    }
+    if (total_time <= 0.0) {
+        return;
+    }
+
+    // Assume the cost is spread evenly over the columns of each strip,
+    // and place the new boundaries where the accumulated cost reaches
+    // an equal share of the total.
+    vector<int> boundaries(num_strips + 1);
+    boundaries.back() = frame.width;
+    const auto share{total_time / static_cast<double>(num_strips)};
+    auto target{share};
+    double cost{};
+    size_t next{1};
+    for (const auto& strip : strips) {
+        const auto density{strip.render_time / strip.width()};
+        while (next < num_strips && cost + strip.render_time >= target) {
+            const auto columns{(target - cost) / density};
+            boundaries[next++] = strip.start + static_cast<int>(columns);
+            target += share;
+        }
+        cost += strip.render_time;
+    }
+    for (; next < num_strips; next++) {
+        boundaries[next] = frame.width;
+    }
+
+    // Move halfway towards the new boundaries to damp oscillations, and
+    // keep every strip wide enough to be worth a thread.
+    for (size_t i = 1; i < num_strips; i++) {
+        const auto old_boundary{strips[i].start};
+        auto boundary{(old_boundary + boundaries[i]) / 2};
+        const auto min{boundaries[i - 1] + min_strip_width};
+        const auto remaining{static_cast<int>(num_strips - i)};
+        const auto max{frame.width - remaining * min_strip_width};
+        boundary = std::clamp(boundary, min, std::max(min, max));
+        boundaries[i] = boundary;
+    }
+    for (size_t i = 0; i < num_strips; i++) {
+        strips[i].start = boundaries[i];
+        strips[i].stop = boundaries[i + 1];
+    }
+}
+
+void Renderer::renderFrame() {
+    if (balancing) {
+        balanceStrips();
+    }
+    workers.run([this](const size_t worker) {
+        if (worker >= strips.size()) {
+            return;
+        }
+        auto& strip{strips[worker]};
+        const auto start_time{std::chrono::steady_clock::now()};
+        renderStrip(strip);
+        const auto end_time{std::chrono::steady_clock::now()};
+        const std::chrono::duration<double> elapsed{end_time - start_time};
+        strip.render_time = elapsed.count();
+    });
+    scratch_used = 0;
+    scratch_high_water = 0;
+    for (const auto& strip : strips) {
+        scratch_used += strip.arena.getUsed();
+        scratch_high_water += strip.arena.getHighWater();
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "draw.h"
+#include "planes.h"
+#include "sprites.h"
+#include "workers.h"
+
+/**
+ * Vertical slice of the view rendered by a single worker. Every strip
+ * owns its clipping state, so workers never share mutable data and the
+ * pixels of a column only depend on the strip that contains it.
+ */
+struct ViewStrip {
+    // Columns covered by the strip, [start, stop).
+    int start;
+    int stop;
+
+    // Highest ceiling row and lowest floor row already drawn in each
+    // column. Sized to the full view, only [start, stop) is used.
+    std::vector<short> ceiling_clip;
+    std::vector<short> floor_clip;
+
+    // Scratch memory of the frame, which the per-frame structures below
+    // are allocated in.
+    FrameArena arena;
+
+    // Floors and ceilings visible in the strip.
+    VisplaneSet planes{};
+
+    // Walls drawn in the strip, binned for clipping the sprites.
+    ArenaVector<Drawseg> drawsegs{};
+    DrawsegBins drawseg_bins{};
+
+    // Sprites visible in the strip.
+    VisspriteList sprites{};
+
+    // Time spent rendering the strip in the previous frame, in seconds.
+    double render_time{};
+
+    // Scratch memory is allocated in the zone.
+    ViewStrip(int start, int stop, int view_width, Zone& zone);
+
+    [[nodiscard]]
+    int width() const {
+        return stop - start;
+    }
+};
+
+/**
+ * Renders the view into the screen buffer, optionally splitting it into
+ * vertical strips that are drawn in parallel. The strip boundaries are
+ * moved every frame so that each worker gets the same share of the
+ * previous frame's rendering time.
+ */
+class Renderer {
+    FrameBuffer frame;
+    Drawer drawer;
+    std::vector<ViewStrip> strips{};
+    WorkerGroup& workers;
+    size_t scratch_used{0};
+    size_t scratch_high_water{0};
+    bool balancing{true};
+    std::function<void(const Drawer&, int)> column_work{};
+
+    void renderStrip(ViewStrip& strip) const;
+    void balanceStrips();
+
+  public:
+    // Render with one strip per worker, as far as the view is wide
+    // enough for it.
+    Renderer(const FrameBuffer& frame, WorkerGroup& workers, Zone& zone);
+
+    // Render a full frame, returning once every strip is done so that
+    // the screen buffer can be presented.
+    void renderFrame();
+
+    // Keep the strips where they are instead of balancing them.
+    void setBalancing(bool enabled) {
+        balancing = enabled;
+    }
+
+    /**
+     * Call work(drawer, x) for every column of the view, from the strip
+     * that holds it, after the strip's own rendering. Until the view is
+     * rendered from the BSP, this gives the strips work to balance for
+     * benchmarks.
+     */
+    void setColumnWork(std::function<void(const Drawer&, int)> work) {
+        column_work = std::move(work);
+    }
+
+    // Bytes of scratch memory the last frame used.
+    [[nodiscard]]
+    size_t getScratchUsed() const {
+        return scratch_used;
+    }
+
+    // Sum of the high-water marks of the strips' scratch memory, which is
+    // about as much as they keep reserved.
+    [[nodiscard]]
+    size_t getScratchHighWater() const {
+        return scratch_high_water;
+    }
+};
@@ -0,0 +1,126 @@
+#include "savegame.h"
+#include "compress.h"
+#include "lump.h"
+#include <algorithm>
+#include <format>
+#include <fstream>
+
+using std::domain_error;
+using std::span;
+using std::vector;
+
+static constexpr char savegame_magic[4]{'D', 'S', 'A', 'V'};
+
+
+static void writeSettings(LumpWriter& writer, const GameSettings& settings) {
+    writer.writeByte(static_cast<Uint8>(settings.skill));
+    writer.writeByte(static_cast<Uint8>(settings.episode));
+    writer.writeByte(static_cast<Uint8>(settings.map));
+    writer.writeByte(settings.deathmatch);
+    writer.writeByte(settings.respawn);
+    writer.writeByte(settings.fast);
+    writer.writeByte(settings.no_monsters);
+    writer.writeByte(static_cast<Uint8>(settings.console_player));
+    for (const auto in_game : settings.player_in_game) {
+        writer.writeByte(in_game);
+    }
+}
+
+static GameSettings readSettings(LumpReader& reader) {
+    GameSettings settings{};
+    settings.skill = reader.readByte();
+    settings.episode = reader.readByte();
+    settings.map = reader.readByte();
+    settings.deathmatch = reader.readByte() != 0;
+    settings.respawn = reader.readByte() != 0;
+    settings.fast = reader.readByte() != 0;
+    settings.no_monsters = reader.readByte() != 0;
+    settings.console_player = reader.readByte();
+    for (auto& in_game : settings.player_in_game) {
+        in_game = reader.readByte() != 0;
+    }
+    if (settings.console_player >= max_players) {
+        throw domain_error{"Savegame has an invalid console player"};
+    }
+    return settings;
+}
+
+static void readHeader(LumpReader& reader) {
+    const auto magic{reader.readSpan(sizeof(savegame_magic))};
+    if (!std::equal(magic.begin(), magic.end(), savegame_magic)) {
+        throw domain_error{"Not a savegame"};
+    }
+    const auto version{static_cast<Uint32>(reader.readInt())};
+    if (version != savegame_version) {
+        const auto error{
+            std::format("Savegame version {} is not supported", version)
+        };
+        throw domain_error{error};
+    }
+}
+
+void writeSaveGame(const Game& game, vector<Uint8>& savegame) {
+    vector<Uint8> state{};
+    game.writeState(state);
+    vector<Uint8> compressed{};
+    compress(state, compressed);
+
+    savegame.clear();
+    savegame.reserve(32 + compressed.size());
+    LumpWriter writer{savegame};
+    writer.write({reinterpret_cast<const Uint8*>(savegame_magic), 4});
+    writer.writeInt(static_cast<Sint32>(savegame_version));
+    writeSettings(writer, game.getSettings());
+    writer.writeInt(static_cast<Sint32>(state.size()));
+    writer.write(compressed);
+}
+
+GameSettings readSaveGameSettings(const span<const Uint8> savegame) {
+    LumpReader reader{savegame};
+    readHeader(reader);
+    return readSettings(reader);
+}
+
+void readSaveGame(Game& game, const span<const Uint8> savegame) {
+    LumpReader reader{savegame};
+    readHeader(reader);
+    const auto settings{readSettings(reader)};
+    const auto& game_settings{game.getSettings()};
+    if (settings.episode != game_settings.episode
+        || settings.map != game_settings.map
+        || settings.player_in_game != game_settings.player_in_game) {
+        throw domain_error{"Savegame is from another game"};
+    }
+    const auto state_size{static_cast<Uint32>(reader.readInt())};
+    const auto compressed{reader.readSpan(reader.size() - reader.tell())};
+    vector<Uint8> state{};
+    decompress(compressed, state_size, state);
+    game.readState(state);
+}
+
+void saveGame(const Game& game, const std::filesystem::path& path) {
+    vector<Uint8> savegame{};
+    writeSaveGame(game, savegame);
+    std::ofstream file{path, std::ios::binary};
+    file.write(reinterpret_cast<const char*>(savegame.data()), savegame.size());
+    if (!file) {
+        const auto error{
+            std::format("Could not write savegame \"{}\"", path.string())
+        };
+        throw domain_error{error};
+    }
+}
+
+vector<Uint8> loadSaveGame(const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    if (!file) {
+        const auto error{
+            std::format("Could not open savegame \"{}\"", path.string())
+        };
+        throw domain_error{error};
+    }
+    return {
+        std::istreambuf_iterator<char>{file},
+        std::istreambuf_iterator<char>{}
+    };
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <SDL.h>
+#include <filesystem>
+#include <span>
+#include <vector>
+#include "game.h"
+
+// Version of the savegame layout, raised whenever the saved state
+// changes, as older savegames then cannot be read.
+static constexpr Uint32 savegame_version{3};
+
+/**
+ * Save the game: a header with the version and the game settings,
+ * followed by the compressed game state.
+ */
+void writeSaveGame(const Game& game, std::vector<Uint8>& savegame);
+
+// Settings of the game a savegame was written from, to start a game on
+// the same map to load it into.
+[[nodiscard]]
+GameSettings readSaveGameSettings(std::span<const Uint8> savegame);
+
+// Load a savegame into a game with the settings it was written with.
+void readSaveGame(Game& game, std::span<const Uint8> savegame);
+
+void saveGame(const Game& game, const std::filesystem::path& path);
+
+[[nodiscard]]
+std::vector<Uint8> loadSaveGame(const std::filesystem::path& path);
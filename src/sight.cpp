@@ -0,0 +1,254 @@
+#include "sight.h"
+#include <algorithm>
+#include <format>
+#include <ostream>
+#include "level.h"
+#include "mobj.h"
+
+
+// Line along which sight is traced.
+struct Divline {
+    fixed_t x;
+    fixed_t y;
+    fixed_t dx;
+    fixed_t dy;
+};
+
+// The sight line being traced, and the slopes from the eyes that are
+// still open along it.
+struct SightTrace {
+    const Level& level;
+    std::span<Uint32> line_stamps;
+    Uint32 stamp;
+    Divline line;
+    fixed_t target_x;
+    fixed_t target_y;
+    fixed_t eye_z;
+    fixed_t top_slope;
+    fixed_t bottom_slope;
+};
+
+SightCache::SightCache(const std::span<SightCacheEntry> entries)
+    : entries{entries} {
+    std::ranges::fill(entries, SightCacheEntry{});
+}
+
+void SightCache::invalidate() {
+    if (++stamp == 0) {
+        std::ranges::fill(entries, SightCacheEntry{});
+        stamp = 1;
+    }
+}
+
+static size_t hashSight(const SightKey& key) {
+    auto hash{key.looker_sector * 0x9e3779b1u};
+    hash ^= key.target_sector * 0x85ebca6bu;
+    hash ^= static_cast<Uint32>(key.looker_x ^ key.target_y) * 0xc2b2ae35u;
+    hash ^= static_cast<Uint32>(key.looker_y ^ key.target_x) * 0x27d4eb2fu;
+    return hash ^ (hash >> 16);
+}
+
+std::optional<bool> SightCache::find(const SightKey& key) const {
+    if (entries.empty()) {
+        return std::nullopt;
+    }
+    const auto& entry{entries[hashSight(key) & (entries.size() - 1)]};
+    if (entry.stamp != stamp || entry.key != key) {
+        return std::nullopt;
+    }
+    return entry.visible;
+}
+
+void SightCache::insert(const SightKey& key, const bool visible) {
+    if (entries.empty()) {
+        return;
+    }
+    auto& entry{entries[hashSight(key) & (entries.size() - 1)]};
+    entry = {.stamp = stamp, .visible = visible, .key = key};
+}
+
+// Side of the line the point is on, 0 for the front, or 2 if it is on
+// the line, as precise as the original.
+static int divlineSide(const fixed_t x, const fixed_t y, const Divline& line) {
+    if (line.dx == 0) {
+        if (x == line.x) {
+            return 2;
+        }
+        return x <= line.x ? line.dy > 0 : line.dy < 0;
+    }
+    if (line.dy == 0) {
+        // The original compares x here, which demos depend on.
+        if (x == line.y) {
+            return 2;
+        }
+        return y <= line.y ? line.dx < 0 : line.dx > 0;
+    }
+    const auto left{(line.dy >> frac_bits) * ((x - line.x) >> frac_bits)};
+    const auto right{((y - line.y) >> frac_bits) * (line.dx >> frac_bits)};
+    if (right < left) {
+        return 0;
+    }
+    return left == right ? 2 : 1;
+}
+
+// Fraction along the trace where it crosses the line.
+static fixed_t interceptVector(const Divline& trace, const Divline& line) {
+    const auto den{
+        fixedMul(line.dy >> 8, trace.dx) - fixedMul(line.dx >> 8, trace.dy)
+    };
+    if (den == 0) {
+        return 0;
+    }
+    const auto num{
+        fixedMul((line.x - trace.x) >> 8, line.dy)
+        + fixedMul((trace.y - line.y) >> 8, line.dx)
+    };
+    return fixedDiv(num, den);
+}
+
+// Whether sight gets through every line of the subsector that the trace
+// crosses, narrowing the open slopes by the openings it goes through.
+static bool crossSubsector(SightTrace& trace, const Subsector& subsector) {
+    const auto segs{trace.level.getSegs()};
+    for (int i = 0; i < subsector.num_segs; i++) {
+        const auto& seg{segs[subsector.first_seg + i]};
+        const auto& line{*seg.line};
+        const auto index{trace.level.lineIndex(line)};
+        if (trace.line_stamps[index] == trace.stamp) {
+            continue;
+        }
+        trace.line_stamps[index] = trace.stamp;
+
+        if (divlineSide(line.v1->x, line.v1->y, trace.line)
+            == divlineSide(line.v2->x, line.v2->y, trace.line)) {
+            continue;
+        }
+        const Divline divline{line.v1->x, line.v1->y, line.dx, line.dy};
+        if (divlineSide(trace.line.x, trace.line.y, divline)
+            == divlineSide(trace.target_x, trace.target_y, divline)) {
+            continue;
+        }
+        if ((line.flags & ml_two_sided) == 0) {
+            return false;
+        }
+
+        const auto& front{*seg.front_sector};
+        const auto& back{*seg.back_sector};
+        const auto same_floor{front.floor_height == back.floor_height};
+        const auto same_ceiling{front.ceiling_height == back.ceiling_height};
+        if (same_floor && same_ceiling) {
+            continue;
+        }
+        const auto top{std::min(front.ceiling_height, back.ceiling_height)};
+        const auto bottom{std::max(front.floor_height, back.floor_height)};
+        if (bottom >= top) {
+            return false;
+        }
+        const auto frac{interceptVector(trace.line, divline)};
+        if (!same_floor) {
+            const auto slope{fixedDiv(bottom - trace.eye_z, frac)};
+            trace.bottom_slope = std::max(trace.bottom_slope, slope);
+        }
+        if (!same_ceiling) {
+            const auto slope{fixedDiv(top - trace.eye_z, frac)};
+            trace.top_slope = std::min(trace.top_slope, slope);
+        }
+        if (trace.top_slope <= trace.bottom_slope) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Whether sight gets through the part of the map under the node, going
+// through the side the trace starts on first.
+static bool crossNode(SightTrace& trace, const Uint16 child) {
+    if (child & node_subsector) {
+        const auto subsectors{trace.level.getSubsectors()};
+        return crossSubsector(trace, subsectors[child & ~node_subsector]);
+    }
+    const auto& node{trace.level.getNodes()[child]};
+    const Divline partition{node.x, node.y, node.dx, node.dy};
+    auto side{divlineSide(trace.line.x, trace.line.y, partition)};
+    if (side == 2) {
+        side = 0;
+    }
+    if (!crossNode(trace, node.children[side])) {
+        return false;
+    }
+    if (side == divlineSide(trace.target_x, trace.target_y, partition)) {
+        return true;
+    }
+    return crossNode(trace, node.children[side ^ 1]);
+}
+
+bool checkSight(Level& level, const Mobj& looker, const Mobj& target) {
+    // Nothing blocks sight on an empty level.
+    if (!looker.sector || !target.sector) {
+        return true;
+    }
+    auto& stats{level.getSightStats()};
+    stats.checks++;
+    if (level.rejectsSight(*looker.sector, *target.sector)) {
+        stats.rejected++;
+        return false;
+    }
+
+    const SightKey key{
+        .looker_sector = level.sectorIndex(*looker.sector),
+        .target_sector = level.sectorIndex(*target.sector),
+        .looker_x = looker.x,
+        .looker_y = looker.y,
+        .eye_z = looker.z + looker.height - (looker.height >> 2),
+        .target_x = target.x,
+        .target_y = target.y,
+        .target_bottom = target.z,
+        .target_top = target.z + target.height,
+    };
+    auto& cache{level.getSightCache()};
+    if (const auto visible{cache.find(key)}) {
+        stats.cached++;
+        return *visible;
+    }
+
+    stats.traced++;
+    SightTrace trace{
+        .level = level,
+        .line_stamps = level.getLineStamps(),
+        .stamp = level.newValidCount(),
+        .line = {
+            .x = looker.x,
+            .y = looker.y,
+            .dx = target.x - looker.x,
+            .dy = target.y - looker.y,
+        },
+        .target_x = target.x,
+        .target_y = target.y,
+        .eye_z = key.eye_z,
+        .top_slope = key.target_top - key.eye_z,
+        .bottom_slope = key.target_bottom - key.eye_z,
+    };
+    const auto nodes{level.getNodes()};
+    const auto root{
+        nodes.empty() ? node_subsector
+                      : static_cast<Uint16>(nodes.size() - 1)
+    };
+    const auto visible{crossNode(trace, root)};
+    cache.insert(key, visible);
+    return visible;
+}
+
+void printSightStats(std::ostream& out, const SightStats& stats) {
+    const auto checks{static_cast<double>(stats.checks)};
+    const auto percent{[&](const Uint64 count) {
+        return checks > 0 ? 100.0 * static_cast<double>(count) / checks : 0.0;
+    }};
+    out << std::format(
+        "{} sight checks: {:.1f}% rejected, {:.1f}% cached, "
+        "{:.1f}% traced\n",
+        stats.checks,
+        percent(stats.rejected),
+        percent(stats.cached),
+        percent(stats.traced)
+    );
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <SDL.h>
+#include <iosfwd>
+#include <optional>
+#include <span>
+#include "fixed.h"
+
+class Level;
+struct Mobj;
+
+// How the sight checks of a level were answered.
+struct SightStats {
+    Uint64 checks{0};
+    // Answered by the REJECT lump without tracing.
+    Uint64 rejected{0};
+    // Answered by the cache of the current tic.
+    Uint64 cached{0};
+    // Traced through the BSP.
+    Uint64 traced{0};
+};
+
+// Everything the result of a sight check depends on besides the map.
+struct SightKey {
+    Uint32 looker_sector;
+    Uint32 target_sector;
+    fixed_t looker_x;
+    fixed_t looker_y;
+    fixed_t eye_z;
+    fixed_t target_x;
+    fixed_t target_y;
+    fixed_t target_bottom;
+    fixed_t target_top;
+
+    bool operator==(const SightKey& other) const = default;
+};
+
+struct SightCacheEntry {
+    Uint32 stamp;
+    bool visible;
+    SightKey key;
+};
+
+/**
+ * Results of the sight checks traced during the current tic, keyed by
+ * the pair of sectors the looker and the target are in. Lookers check
+ * the same targets several times a tic, and an entry only answers checks
+ * between the same points, as sight within a sector depends on where
+ * the mobjs stand, so the cache never changes what a check returns.
+ * Entries are stamped instead of cleared: a new tic, or a sector moving,
+ * only raises the stamp.
+ */
+class SightCache {
+    std::span<SightCacheEntry> entries{};
+    Uint32 stamp{1};
+
+  public:
+    // Cache that holds nothing.
+    SightCache() = default;
+
+    // Cache over entries, whose count is a power of two.
+    explicit SightCache(std::span<SightCacheEntry> entries);
+
+    // Forget every result, at the start of a tic or when a sector moves.
+    void invalidate();
+
+    [[nodiscard]]
+    std::optional<bool> find(const SightKey& key) const;
+
+    void insert(const SightKey& key, bool visible);
+};
+
+// Whether the looker's eyes can see any part of the target, as the
+// original P_CheckSight.
+bool checkSight(Level& level, const Mobj& looker, const Mobj& target);
+
+void printSightStats(std::ostream& out, const SightStats& stats);
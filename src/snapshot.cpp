@@ -0,0 +1,242 @@
+#include "snapshot.h"
+#include "demo.h"
+#include "game.h"
+#include "lump.h"
+#include "stats.h"
+#include <algorithm>
+#include <stdexcept>
+
+using std::span;
+using std::vector;
+
+// Snapshots between two key snapshots, which bounds the deltas decoded
+// to restore one.
+static constexpr size_t key_snapshot_interval{16};
+
+
+static void writeVarint(vector<Uint8>& out, size_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<Uint8>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<Uint8>(value));
+}
+
+static size_t readVarint(LumpReader& reader) {
+    size_t value{0};
+    for (int shift = 0;; shift += 7) {
+        const auto byte{reader.readByte()};
+        value |= static_cast<size_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+}
+
+static Uint8 baseByte(const span<const Uint8> base, const size_t i) {
+    return base.empty() ? 0 : base[i];
+}
+
+void encodeDelta(
+    const span<const Uint8> base,
+    const span<const Uint8> state,
+    vector<Uint8>& delta
+) {
+    delta.clear();
+    writeVarint(delta, state.size());
+
+    // Alternating runs of unchanged bytes and of changed bytes, the
+    // latter followed by their XOR with the base.
+    size_t pos{0};
+    while (pos < state.size()) {
+        const auto run_start{pos};
+        while (pos < state.size() && state[pos] == baseByte(base, pos)) {
+            pos++;
+        }
+        writeVarint(delta, pos - run_start);
+        const auto changed_start{pos};
+        while (pos < state.size() && state[pos] != baseByte(base, pos)) {
+            pos++;
+        }
+        writeVarint(delta, pos - changed_start);
+        for (auto i{changed_start}; i < pos; i++) {
+            delta.push_back(state[i] ^ baseByte(base, i));
+        }
+    }
+}
+
+void decodeDelta(
+    const span<const Uint8> base,
+    const span<const Uint8> delta,
+    vector<Uint8>& state
+) {
+    LumpReader reader{delta};
+    const auto size{readVarint(reader)};
+    if (!base.empty() && base.size() != size) {
+        throw std::domain_error{"Delta does not match its base state"};
+    }
+    state.resize(size);
+    if (base.empty()) {
+        std::fill(state.begin(), state.end(), 0);
+    } else {
+        std::copy(base.begin(), base.end(), state.begin());
+    }
+    size_t pos{0};
+    while (reader.tell() < reader.size()) {
+        pos += readVarint(reader);
+        const auto changed{readVarint(reader)};
+        if (changed > size - std::min(pos, size)) {
+            throw std::domain_error{"Delta is larger than its state"};
+        }
+        for (const auto byte : reader.readSpan(changed)) {
+            state[pos++] ^= byte;
+        }
+    }
+}
+
+
+SnapshotTimeline::SnapshotTimeline(const Uint32 interval)
+    : interval{interval} {
+}
+
+void SnapshotTimeline::capture(const Game& game) {
+    const auto next_tic{static_cast<Uint32>(snapshots.size()) * interval};
+    if (game.getTic() != next_tic) {
+        return;
+    }
+    game.writeState(state);
+
+    // A state that changed size cannot be a delta to the previous one.
+    const auto key{
+        snapshots.size() % key_snapshot_interval == 0
+        || state.size() != last_state.size()
+    };
+    Snapshot snapshot{next_tic, key, {}};
+    encodeDelta(key ? span<const Uint8>{} : last_state, state, snapshot.delta);
+    snapshot.delta.shrink_to_fit();
+    snapshots.push_back(std::move(snapshot));
+    std::swap(last_state, state);
+}
+
+bool SnapshotTimeline::restore(Game& game, const Uint32 tic) {
+    if (snapshots.empty()) {
+        return false;
+    }
+    const auto closest{std::min<size_t>(tic / interval, snapshots.size() - 1)};
+    if (game.getTic() >= snapshots[closest].tic && game.getTic() <= tic) {
+        return true;
+    }
+
+    auto first{closest};
+    while (!snapshots[first].key) {
+        first--;
+    }
+    vector<Uint8> restored{};
+    decodeDelta({}, snapshots[first].delta, restored);
+    for (auto i{first + 1}; i <= closest; i++) {
+        decodeDelta(restored, snapshots[i].delta, state);
+        std::swap(restored, state);
+    }
+    game.readState(restored);
+    return true;
+}
+
+size_t SnapshotTimeline::memoryUsage() const {
+    size_t bytes{0};
+    for (const auto& snapshot : snapshots) {
+        bytes += snapshot.delta.capacity();
+    }
+    return bytes;
+}
+
+
+RewindBuffer::RewindBuffer(const size_t memory_limit, const Uint32 interval)
+    : memory_limit{memory_limit}
+    , interval{interval} {
+}
+
+void RewindBuffer::dropOldest() {
+    stats.memory -= older.front().capacity();
+    older.pop_front();
+}
+
+void RewindBuffer::capture(const Game& game) {
+    const auto tic{game.getTic()};
+    if (tic % interval != 0 || (!newest.empty() && tic <= newest_tic)) {
+        return;
+    }
+    Stopwatch stopwatch;
+    game.writeState(state);
+    if (newest.size() == state.size()) {
+        std::vector<Uint8> delta{};
+        encodeDelta(state, newest, delta);
+        delta.shrink_to_fit();
+        stats.last_size = delta.size();
+        stats.memory += delta.capacity();
+        older.push_back(std::move(delta));
+    } else {
+        // The state changed size, so it cannot be a base for the older
+        // snapshots.
+        while (!older.empty()) {
+            dropOldest();
+        }
+        stats.last_size = state.size();
+    }
+    stats.memory += state.capacity();
+    stats.memory -= newest.capacity();
+    std::swap(newest, state);
+    newest_tic = tic;
+    while (!older.empty() && stats.memory > memory_limit) {
+        dropOldest();
+    }
+
+    stats.snapshots++;
+    stats.last_time = stopwatch.lap();
+    stats.total_time += stats.last_time;
+    stats.max_time = std::max(stats.max_time, stats.last_time);
+}
+
+bool RewindBuffer::rewind(Game& game) {
+    if (newest.empty()) {
+        return false;
+    }
+    if (game.getTic() <= newest_tic) {
+        if (older.empty()) {
+            return false;
+        }
+        decodeDelta(newest, older.back(), state);
+        stats.memory -= older.back().capacity();
+        older.pop_back();
+        stats.memory += state.capacity();
+        stats.memory -= newest.capacity();
+        std::swap(newest, state);
+        newest_tic -= interval;
+    }
+    game.readState(newest);
+    return true;
+}
+
+void RewindBuffer::clear() {
+    older.clear();
+    newest = {};
+    newest_tic = 0;
+    stats.memory = 0;
+}
+
+
+void seekDemo(
+    Game& game,
+    const Demo& demo,
+    SnapshotTimeline& timeline,
+    Uint32 tic
+) {
+    tic = std::min(tic, static_cast<Uint32>(demo.getNumTics()));
+    timeline.capture(game);
+    if (!timeline.restore(game, tic) && tic < game.getTic()) {
+        throw std::domain_error{"No snapshot to seek back to"};
+    }
+    while (game.getTic() < tic) {
+        game.ticker(demo.getTic(game.getTic()));
+        timeline.capture(game);
+    }
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <SDL.h>
+#include <deque>
+#include <span>
+#include <vector>
+
+class Demo;
+class Game;
+
+/**
+ * Encode a state as the difference to a base state of the same size:
+ * the two are XORed and the runs of zero bytes in the result, which is
+ * everything that did not change, are run length encoded. An empty
+ * base encodes the state on its own.
+ */
+void encodeDelta(
+    std::span<const Uint8> base,
+    std::span<const Uint8> state,
+    std::vector<Uint8>& delta
+);
+
+// Rebuild the state from the base it was encoded against.
+void decodeDelta(
+    std::span<const Uint8> base,
+    std::span<const Uint8> delta,
+    std::vector<Uint8>& state
+);
+
+/**
+ * Snapshots of a game taken at regular tic intervals, so that it can be
+ * brought back to any earlier tic by restoring the closest snapshot and
+ * running forward from there. Snapshots are stored as deltas to the one
+ * before, with a full key snapshot every few so that restoring never
+ * decodes a long chain.
+ */
+class SnapshotTimeline {
+    struct Snapshot {
+        Uint32 tic;
+        // Key snapshots are encoded on their own, the others as a delta
+        // to the previous snapshot.
+        bool key;
+        std::vector<Uint8> delta;
+    };
+
+    Uint32 interval;
+    std::vector<Snapshot> snapshots{};
+
+    // State of the last snapshot, the base of the next delta.
+    std::vector<Uint8> last_state{};
+    std::vector<Uint8> state{};
+
+  public:
+    explicit SnapshotTimeline(Uint32 interval);
+
+    // Take a snapshot if the game is at the next snapshot tic.
+    void capture(const Game& game);
+
+    /**
+     * Bring the game to the last snapshot at or before the tic, unless
+     * the game is already between it and the tic. Returns false if
+     * there is no such snapshot.
+     */
+    bool restore(Game& game, Uint32 tic);
+
+    // Bytes taken by the snapshots.
+    [[nodiscard]]
+    size_t memoryUsage() const;
+};
+
+// Cost of the snapshots taken by a RewindBuffer.
+struct RewindStats {
+    size_t snapshots{0};
+    // Bytes taken by the snapshots kept.
+    size_t memory{0};
+    size_t last_size{0};
+    double last_time{0.0};
+    double total_time{0.0};
+    double max_time{0.0};
+};
+
+/**
+ * Snapshots of a game taken at regular tic intervals, to rewind it to
+ * the last few of them. The newest snapshot is kept whole and each
+ * older one as a delta to the snapshot after it, so that the oldest can
+ * be dropped at any time to stay within the memory limit.
+ */
+class RewindBuffer {
+    size_t memory_limit;
+    Uint32 interval;
+
+    // Deltas back from each snapshot to the one before, oldest first.
+    std::deque<std::vector<Uint8>> older{};
+    std::vector<Uint8> newest{};
+    Uint32 newest_tic{0};
+    std::vector<Uint8> state{};
+    RewindStats stats{};
+
+    void dropOldest();
+
+  public:
+    RewindBuffer(size_t memory_limit, Uint32 interval);
+
+    // Take a snapshot if the game reached the next snapshot tic.
+    void capture(const Game& game);
+
+    /**
+     * Bring the game back to the newest snapshot, or to the one before
+     * if it is at that snapshot already. Later snapshots are dropped.
+     * Returns false if there is nothing to rewind to.
+     */
+    bool rewind(Game& game);
+
+    // Drop every snapshot, when the game jumps to an unrelated state.
+    void clear();
+
+    [[nodiscard]]
+    const RewindStats& getStats() const {
+        return stats;
+    }
+};
+
+/**
+ * Move a game playing back a demo to the given tic, restoring the
+ * closest snapshot before it and playing the demo forward from there,
+ * taking new snapshots on the way.
+ */
+void seekDemo(
+    Game& game,
+    const Demo& demo,
+    SnapshotTimeline& timeline,
+    Uint32 tic
+);
@@ -0,0 +1,142 @@
+#include "sprites.h"
+
+using std::span;
+
+// The sort looks at one byte of the scale per pass.
+static constexpr int radix_bits{8};
+static constexpr size_t radix_size{1 << radix_bits};
+
+
+Vissprite* VisspriteList::newSprite() {
+    const auto sprite{arena->allocate<Vissprite>(1)};
+    sprites.push_back(sprite);
+    return sprite;
+}
+
+span<Vissprite* const> VisspriteList::sort() {
+    const auto count{sprites.size()};
+    if (count < 2) {
+        return {sprites.data(), count};
+    }
+
+    // Least significant digit first, counting every digit in one go.
+    // Scales are positive, so they sort as unsigned numbers.
+    size_t counts[sizeof(fixed_t)][radix_size]{};
+    for (const auto sprite : sprites) {
+        const auto key{static_cast<Uint32>(sprite->scale)};
+        for (size_t digit = 0; digit < sizeof(fixed_t); digit++) {
+            counts[digit][(key >> (digit * radix_bits)) & 0xff]++;
+        }
+    }
+
+    auto from{sprites.data()};
+    auto to{arena->allocate<Vissprite*>(count)};
+    for (size_t digit = 0; digit < sizeof(fixed_t); digit++) {
+        auto& digit_counts{counts[digit]};
+        // Skip digits that are the same in every scale.
+        const auto key{static_cast<Uint32>(from[0]->scale)};
+        if (digit_counts[(key >> (digit * radix_bits)) & 0xff] == count) {
+            continue;
+        }
+        size_t offset{};
+        for (auto& bucket : digit_counts) {
+            const auto bucket_count{bucket};
+            bucket = offset;
+            offset += bucket_count;
+        }
+        for (size_t i = 0; i < count; i++) {
+            const auto sprite{from[i]};
+            const auto sprite_key{static_cast<Uint32>(sprite->scale)};
+            to[digit_counts[(sprite_key >> (digit * radix_bits)) & 0xff]++] =
+                sprite;
+        }
+        std::swap(from, to);
+    }
+    if (from != sprites.data()) {
+        std::copy_n(from, count, sprites.data());
+    }
+    return {sprites.data(), count};
+}
+
+void DrawsegBins::build(
+    ZoneArena& frame_arena,
+    const span<const Drawseg> frame_drawsegs,
+    const int start,
+    const int stop
+) {
+    drawsegs = frame_drawsegs;
+    first_x = start;
+    const auto num_bins{static_cast<size_t>(
+        (stop - start + drawseg_bin_width - 1) / drawseg_bin_width
+    )};
+
+    // Bins of the drawsegs that can clip sprites, as first and last bin,
+    // or first after last for the rest. Solid walls are handled by the
+    // clip arrays during the BSP traversal and never clip sprites.
+    const auto binRange{[&](const Drawseg& ds) {
+        const auto x1{std::max(ds.x1, start)};
+        const auto x2{std::min(ds.x2, stop - 1)};
+        if ((!ds.silhouette && !ds.masked_texture_col) || x1 > x2) {
+            return std::pair{1, 0};
+        }
+        return std::pair{
+            (x1 - start) / drawseg_bin_width,
+            (x2 - start) / drawseg_bin_width
+        };
+    }};
+
+    // Count the drawsegs of each bin, then place them in bin order.
+    bin_starts = frame_arena.allocateArray<Uint32>(num_bins + 1);
+    for (const auto& ds : drawsegs) {
+        const auto [first_bin, last_bin]{binRange(ds)};
+        for (auto bin = first_bin; bin <= last_bin; bin++) {
+            bin_starts[bin + 1]++;
+        }
+    }
+    for (size_t bin = 0; bin < num_bins; bin++) {
+        bin_starts[bin + 1] += bin_starts[bin];
+    }
+    indices = {frame_arena.allocate<Sint32>(bin_starts[num_bins]),
+               bin_starts[num_bins]};
+    for (size_t i = 0; i < drawsegs.size(); i++) {
+        const auto [first_bin, last_bin]{binRange(drawsegs[i])};
+        for (auto bin = first_bin; bin <= last_bin; bin++) {
+            indices[bin_starts[bin]++] = static_cast<Sint32>(i);
+        }
+    }
+    // Placing moved every start to the next bin's.
+    for (auto bin{num_bins}; bin > 0; bin--) {
+        bin_starts[bin] = bin_starts[bin - 1];
+    }
+    bin_starts[0] = 0;
+}
+
+bool pointOnSegSide(const fixed_t x, const fixed_t y, const Drawseg& drawseg) {
+    const auto lx{drawseg.line_x};
+    const auto ly{drawseg.line_y};
+    const auto ldx{drawseg.line_dx};
+    const auto ldy{drawseg.line_dy};
+    if (ldx == 0) {
+        if (x <= lx) {
+            return ldy > 0;
+        }
+        return ldy < 0;
+    }
+    if (ldy == 0) {
+        if (y <= ly) {
+            return ldx < 0;
+        }
+        return ldx > 0;
+    }
+
+    const auto dx{x - lx};
+    const auto dy{y - ly};
+
+    // Try to quickly decide by looking at sign bits.
+    if ((ldy ^ ldx ^ dx ^ dy) & 0x80000000) {
+        return ((ldy ^ dx) & 0x80000000) != 0;
+    }
+    const auto left{fixedMul(ldy >> frac_bits, dx)};
+    const auto right{fixedMul(dy, ldx >> frac_bits)};
+    return right >= left;
+}
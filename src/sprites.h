@@ -0,0 +1,225 @@
+#pragma once
+
+#include <SDL.h>
+#include <algorithm>
+#include <span>
+#include "fixed.h"
+#include "zone.h"
+
+// Which sides of a drawseg hide the sprites behind it.
+static constexpr int silhouette_bottom{1};
+static constexpr int silhouette_top{2};
+
+// Clip row of a column no drawseg has clipped yet.
+static constexpr short unclipped{-2};
+
+/**
+ * A wall segment drawn in the frame, kept for clipping the sprites and
+ * masked textures drawn after the walls.
+ */
+struct Drawseg {
+    // Columns covered by the segment, and scale at both ends.
+    int x1;
+    int x2;
+    fixed_t scale1;
+    fixed_t scale2;
+
+    // Start and delta of the seg in map space, to tell on which side of
+    // it a sprite stands.
+    fixed_t line_x;
+    fixed_t line_y;
+    fixed_t line_dx;
+    fixed_t line_dy;
+
+    int silhouette;
+    fixed_t bottom_sil_height;
+    fixed_t top_sil_height;
+
+    // Clip rows for sprites, indexed by x - x1.
+    const short* sprite_top_clip;
+    const short* sprite_bottom_clip;
+
+    // Texture columns of the masked middle texture, indexed by x - x1,
+    // or null if the segment has none.
+    short* masked_texture_col;
+};
+
+/**
+ * A sprite projected on the screen during the BSP traversal.
+ */
+struct Vissprite {
+    // Columns covered by the sprite.
+    int x1;
+    int x2;
+
+    // Position of the thing in map space, and bottom and top height.
+    fixed_t gx;
+    fixed_t gy;
+    fixed_t gz;
+    fixed_t gzt;
+
+    fixed_t start_frac;
+    fixed_t scale;
+    fixed_t x_iscale;
+    fixed_t texture_mid;
+    int patch;
+    const Uint8* colormap;
+};
+
+/**
+ * The sprites of a frame, or of one strip of it. Sprites are allocated
+ * from the frame arena and sorted back to front with a stable radix sort
+ * on their scale, which draws them in the same order as the original
+ * selection sort.
+ */
+class VisspriteList {
+    ZoneArena* arena{nullptr};
+    ArenaVector<Vissprite*> sprites{};
+
+  public:
+    // Forget every sprite and allocate in the arena of the frame.
+    void clear(ZoneArena& frame_arena) {
+        arena = &frame_arena;
+        sprites.clear(frame_arena);
+    }
+
+    [[nodiscard]]
+    size_t size() const {
+        return sprites.size();
+    }
+
+    Vissprite* newSprite();
+
+    // Sprites in drawing order, from the farthest to the closest.
+    [[nodiscard]]
+    std::span<Vissprite* const> sort();
+};
+
+/**
+ * Drawsegs binned by the screen columns they cover. Clipping a sprite
+ * then only visits the drawsegs of the bins it overlaps rather than
+ * every drawseg of the frame, which matters when thousands of sprites
+ * are visible.
+ */
+class DrawsegBins {
+    // Drawsegs of bin b are indices[bin_starts[b], bin_starts[b + 1]),
+    // in drawing order. Both live in the frame arena.
+    std::span<Uint32> bin_starts{};
+    std::span<Sint32> indices{};
+    std::span<const Drawseg> drawsegs{};
+    int first_x{};
+
+  public:
+    // Bin the drawsegs that can clip sprites, for the columns
+    // [start, stop) of the view, allocating in the arena of the frame.
+    void build(
+        ZoneArena& frame_arena,
+        std::span<const Drawseg> frame_drawsegs,
+        int start,
+        int stop
+    );
+
+    /**
+     * Compute the rows a sprite may be drawn between in each of its
+     * columns: clip_top and clip_bottom are indexed by x - sprite.x1.
+     * Masked textures in front of the sprite must be drawn first, which
+     * is done by calling draw_masked(drawseg, x1, x2) for each of them.
+     */
+    template <typename DrawMasked>
+    void clipSprite(
+        const Vissprite& sprite,
+        short* clip_top,
+        short* clip_bottom,
+        int view_height,
+        DrawMasked&& draw_masked
+    ) const;
+};
+
+// Whether the point is on the back side of the drawseg's seg.
+bool pointOnSegSide(fixed_t x, fixed_t y, const Drawseg& drawseg);
+
+// Width of the column ranges drawsegs are binned by.
+static constexpr int drawseg_bin_width{32};
+
+template <typename DrawMasked>
+void DrawsegBins::clipSprite(
+    const Vissprite& sprite,
+    short* clip_top,
+    short* clip_bottom,
+    const int view_height,
+    DrawMasked&& draw_masked
+) const {
+    const auto width{sprite.x2 - sprite.x1 + 1};
+    std::fill_n(clip_top, width, unclipped);
+    std::fill_n(clip_bottom, width, unclipped);
+
+    // Within a column the closest drawseg, the last one drawn, wins. A
+    // bin holds its drawsegs in drawing order, so walking each bin
+    // backwards gives the same clipping as walking every drawseg.
+    const auto max_bin{static_cast<int>(bin_starts.size()) - 2};
+    const auto first_bin{
+        std::max((sprite.x1 - first_x) / drawseg_bin_width, 0)
+    };
+    const auto last_bin{
+        std::min((sprite.x2 - first_x) / drawseg_bin_width, max_bin)
+    };
+    for (auto bin = first_bin; bin <= last_bin; bin++) {
+        const auto bin_x1{first_x + bin * drawseg_bin_width};
+        const auto bin_x2{bin_x1 + drawseg_bin_width - 1};
+        const auto bin_start{bin_starts[bin]};
+        for (auto i{bin_starts[bin + 1]}; i-- > bin_start;) {
+            const auto& ds{drawsegs[indices[i]]};
+            if (ds.x1 > sprite.x2 || ds.x2 < sprite.x1) {
+                continue;
+            }
+            const auto r1{std::max({ds.x1, sprite.x1, bin_x1})};
+            const auto r2{std::min({ds.x2, sprite.x2, bin_x2})};
+            if (r1 > r2) {
+                continue;
+            }
+
+            const auto scale{std::max(ds.scale1, ds.scale2)};
+            const auto low_scale{std::min(ds.scale1, ds.scale2)};
+            if (scale < sprite.scale
+                || (low_scale < sprite.scale
+                    && !pointOnSegSide(sprite.gx, sprite.gy, ds))) {
+                // The seg is behind the sprite, only its masked texture
+                // has to be drawn before it.
+                if (ds.masked_texture_col) {
+                    draw_masked(ds, r1, r2);
+                }
+                continue;
+            }
+
+            auto silhouette{ds.silhouette};
+            if (sprite.gz >= ds.bottom_sil_height) {
+                silhouette &= ~silhouette_bottom;
+            }
+            if (sprite.gzt <= ds.top_sil_height) {
+                silhouette &= ~silhouette_top;
+            }
+            for (auto x = r1; x <= r2; x++) {
+                const auto clip{x - sprite.x1};
+                const auto ds_x{x - ds.x1};
+                if ((silhouette & silhouette_bottom)
+                    && clip_bottom[clip] == unclipped) {
+                    clip_bottom[clip] = ds.sprite_bottom_clip[ds_x];
+                }
+                if ((silhouette & silhouette_top)
+                    && clip_top[clip] == unclipped) {
+                    clip_top[clip] = ds.sprite_top_clip[ds_x];
+                }
+            }
+        }
+    }
+
+    // Columns no drawseg clipped span the whole view.
+    for (int i = 0; i < width; i++) {
+        if (clip_bottom[i] == unclipped) {
+            clip_bottom[i] = static_cast<short>(view_height);
+        }
+        if (clip_top[i] == unclipped) {
+            clip_top[i] = -1;
+        }
+    }
+}
@@ -0,0 +1,100 @@
+#include "stats.h"
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <numeric>
+#include <ostream>
+
+using std::vector;
+
+double Stopwatch::lap() {
+    const auto now{Clock::now()};
+    const std::chrono::duration<double, std::milli> elapsed{now - last_lap};
+    last_lap = now;
+    return elapsed.count();
+}
+
+void printFrameTiming(
+    std::ostream& out,
+    const Uint64 frame,
+    const FrameTiming& timing
+) {
+    out << std::format(
+        "frame {}: {:.3f} ms "
+        "(tic {:.3f}, render {:.3f}, hud {:.3f}, present {:.3f}), "
+        "scratch {} bytes (high-water mark {} bytes)\n",
+        frame,
+        timing.total(),
+        timing.tic,
+        timing.render,
+        timing.hud,
+        timing.present,
+        timing.scratch,
+        timing.scratch_high_water
+    );
+}
+
+// Nearest-rank percentile of sorted frame times.
+static double percentile(const vector<double>& sorted, const double p) {
+    const auto rank{std::ceil(p / 100.0 * static_cast<double>(sorted.size()))};
+    const auto index{std::max(static_cast<size_t>(rank), size_t{1}) - 1};
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+void FrameStats::printSummary(std::ostream& out) const {
+    if (frames.empty()) {
+        out << "No frames timed\n";
+        return;
+    }
+    vector<double> totals(frames.size());
+    std::transform(
+        frames.begin(), frames.end(), totals.begin(),
+        [](const FrameTiming& timing) { return timing.total(); }
+    );
+    std::sort(totals.begin(), totals.end());
+    const auto elapsed{std::accumulate(totals.begin(), totals.end(), 0.0)};
+    const auto fps{static_cast<double>(frames.size()) * 1000.0 / elapsed};
+    const auto max_scratch{
+        std::ranges::max(frames, {}, &FrameTiming::scratch).scratch
+    };
+    const auto high_water{
+        std::ranges::max(
+            frames, {}, &FrameTiming::scratch_high_water
+        ).scratch_high_water
+    };
+    out << std::format(
+        "timed {} tics in {:.1f} ms ({:.2f} fps)\n"
+        "frame time p50 {:.3f} ms, p95 {:.3f} ms, p99 {:.3f} ms, "
+        "max {:.3f} ms\n"
+        "renderer scratch {} bytes at most in a frame, "
+        "high-water mark {} bytes\n",
+        frames.size(),
+        elapsed,
+        fps,
+        percentile(totals, 50),
+        percentile(totals, 95),
+        percentile(totals, 99),
+        totals.back(),
+        max_scratch,
+        high_water
+    );
+}
+
+void FrameStats::writeCsv(std::ostream& out) const {
+    out << "frame,total_ms,tic_ms,render_ms,hud_ms,present_ms,scratch_bytes,"
+           "scratch_high_water_bytes\n";
+    for (size_t frame = 0; frame < frames.size(); frame++) {
+        const auto& timing{frames[frame]};
+        out << std::format(
+            "{},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f},{},{}\n",
+            frame,
+            timing.total(),
+            timing.tic,
+            timing.render,
+            timing.hud,
+            timing.present,
+            timing.scratch,
+            timing.scratch_high_water
+        );
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <SDL.h>
+#include <chrono>
+#include <iosfwd>
+#include <vector>
+
+/**
+ * Measures the time between consecutive laps.
+ */
+class Stopwatch {
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point last_lap{Clock::now()};
+
+  public:
+    // Milliseconds since the previous lap, or since construction.
+    double lap();
+};
+
+// Time spent in each stage of a frame, in milliseconds.
+struct FrameTiming {
+    double tic;
+    double render;
+    double hud;
+    double present;
+
+    // Bytes of renderer scratch memory the frame used, and the most the
+    // renderer used so far.
+    size_t scratch;
+    size_t scratch_high_water;
+
+    [[nodiscard]]
+    double total() const {
+        return tic + render + hud + present;
+    }
+};
+
+/**
+ * Timings of every frame of a benchmark run.
+ */
+class FrameStats {
+    std::vector<FrameTiming> frames{};
+
+  public:
+    void add(const FrameTiming& timing) {
+        frames.push_back(timing);
+    }
+
+    // Frame count, average FPS and frame time percentiles.
+    void printSummary(std::ostream& out) const;
+
+    // One line per frame with the time of each of its stages.
+    void writeCsv(std::ostream& out) const;
+};
+
+// Write the timing of a frame as a single line.
+void printFrameTiming(
+    std::ostream& out,
+    Uint64 frame,
+    const FrameTiming& timing
+);
@@ -0,0 +1,184 @@
+#include "tables.h"
+#include <numbers>
+#include <span>
+
+using std::numbers::pi;
+
+// The standard trigonometric functions are not constexpr, so the tables
+// are built from series accurate to a few units in the last place of a
+// double, far below what truncating to fixed point can tell apart.
+
+// Sine and cosine of |x| <= pi / 4.
+static constexpr double sineSeries(const double x) {
+    double term{x};
+    double sum{x};
+    for (int n = 1; n < 14; n++) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+static constexpr double cosineSeries(const double x) {
+    double term{1.0};
+    double sum{1.0};
+    for (int n = 1; n < 14; n++) {
+        term *= -x * x / ((2 * n - 1) * (2 * n));
+        sum += term;
+    }
+    return sum;
+}
+
+static constexpr double sine(const double x) {
+    const auto quadrant{static_cast<long long>(x / (pi / 2) + 0.5)};
+    const auto r{x - static_cast<double>(quadrant) * (pi / 2)};
+    switch (quadrant & 3) {
+    case 0:
+        return sineSeries(r);
+    case 1:
+        return cosineSeries(r);
+    case 2:
+        return -sineSeries(r);
+    default:
+        return -cosineSeries(r);
+    }
+}
+
+static constexpr double cosine(const double x) {
+    return sine(x + pi / 2);
+}
+
+static constexpr double squareRoot(const double x) {
+    double root{x > 1.0 ? x : 1.0};
+    for (int i = 0; i < 64; i++) {
+        root = (root + x / root) / 2;
+    }
+    return root;
+}
+
+// Arctangent of 0 <= x <= 1. Halving the angle twice brings x below
+// tan(pi / 16), where the series converges quickly.
+static constexpr double arcTangent(double x) {
+    for (int i = 0; i < 2; i++) {
+        x /= 1.0 + squareRoot(1.0 + x * x);
+    }
+    double term{x};
+    double sum{x};
+    for (int n = 1; n < 20; n++) {
+        term *= -x * x;
+        sum += term / (2 * n + 1);
+    }
+    return 4 * sum;
+}
+
+// The original generator sampled both tables at the middle of each fine
+// angle, so that no entry is exactly zero. It used a slightly rounded pi
+// and kept the angles, and the tangents before truncating them, in single
+// precision, which the tables reproduce entry for entry.
+static constexpr double original_pi{3.141592657};
+
+static constexpr double fineAngle(const double step) {
+    return static_cast<float>(step * original_pi * 2 / fine_angles);
+}
+
+static constexpr auto makeFineSine() {
+    std::array<fixed_t, fine_angles * 5 / 4> table{};
+    for (size_t i = 0; i < table.size(); i++) {
+        const auto angle{fineAngle(static_cast<double>(i) + 0.5)};
+        table[i] = static_cast<fixed_t>(frac_unit * sine(angle));
+    }
+    return table;
+}
+
+static constexpr auto makeFineTangent() {
+    std::array<fixed_t, fine_angles / 2> table{};
+    for (size_t i = 0; i < table.size(); i++) {
+        const auto step{static_cast<double>(i) - fine_angles / 4 + 0.5};
+        const auto angle{fineAngle(step)};
+        const auto tangent{frac_unit * sine(angle) / cosine(angle)};
+        table[i] = static_cast<fixed_t>(static_cast<float>(tangent));
+    }
+    return table;
+}
+
+static constexpr auto makeTanToAngle() {
+    std::array<angle_t, slope_range + 1> table{};
+    for (size_t i = 0; i < table.size(); i++) {
+        const auto slope{static_cast<double>(i) / slope_range};
+        table[i] = static_cast<angle_t>(arcTangent(slope) * (ang180 / pi));
+    }
+    return table;
+}
+
+constexpr std::array<fixed_t, fine_angles * 5 / 4> finesine{makeFineSine()};
+constexpr std::array<fixed_t, fine_angles / 2> finetangent{makeFineTangent()};
+constexpr std::array<angle_t, slope_range + 1> tantoangle{makeTanToAngle()};
+
+// Entries of the original tables.
+static_assert(finesine[0] == 25 && finesine[1] == 75 && finesine[2] == 125);
+static_assert(finesine[fine_angles / 4 - 1] == 65535);
+static_assert(finesine[fine_angles / 4] == 65535);
+static_assert(finesine[fine_angles / 2] == -25);
+static_assert(finetangent[fine_angles / 4] == 25);
+static_assert(finetangent[fine_angles / 4 - 1] == -25);
+static_assert(finetangent[0] == -170910304 && finetangent[1] == -56965752);
+static_assert(tantoangle[0] == 0 && tantoangle[1] == 333772);
+static_assert(tantoangle[8] == 2670163 && tantoangle[15] == 5006492);
+static_assert(tantoangle[slope_range] == ang45);
+
+// Checksums of the whole of the original tables.
+template <typename T>
+static constexpr Uint32 checksum(const std::span<const T> table) {
+    Uint32 sum{0};
+    for (const auto value : table) {
+        sum = sum * 31 + static_cast<Uint32>(value);
+    }
+    return sum;
+}
+
+static_assert(checksum<fixed_t>(finesine) == 1041296847);
+static_assert(checksum<fixed_t>(finetangent) == 3206741600);
+static_assert(checksum<angle_t>(tantoangle) == 2161749139);
+
+
+int slopeDiv(const Uint32 num, const Uint32 den) {
+    if (den < 512) {
+        return slope_range;
+    }
+    const auto slope{(num << 3) / (den >> 8)};
+    return static_cast<int>(slope <= slope_range ? slope : slope_range);
+}
+
+angle_t pointToAngle(fixed_t x, fixed_t y) {
+    if (x == 0 && y == 0) {
+        return 0;
+    }
+    // Fold the vector into the first octant, look up its angle there and
+    // unfold it. Each octant picks the larger coordinate as denominator.
+    const auto ux{[](const fixed_t v) { return static_cast<Uint32>(v); }};
+    if (x >= 0) {
+        if (y >= 0) {
+            if (x > y) {
+                return tantoangle[slopeDiv(ux(y), ux(x))];
+            }
+            return ang90 - 1 - tantoangle[slopeDiv(ux(x), ux(y))];
+        }
+        y = -y;
+        if (x > y) {
+            return -tantoangle[slopeDiv(ux(y), ux(x))];
+        }
+        return ang270 + tantoangle[slopeDiv(ux(x), ux(y))];
+    }
+    x = -x;
+    if (y >= 0) {
+        if (x > y) {
+            return ang180 - 1 - tantoangle[slopeDiv(ux(y), ux(x))];
+        }
+        return ang90 + tantoangle[slopeDiv(ux(x), ux(y))];
+    }
+    y = -y;
+    if (x > y) {
+        return ang180 + tantoangle[slopeDiv(ux(y), ux(x))];
+    }
+    return ang270 - 1 - tantoangle[slopeDiv(ux(x), ux(y))];
+}
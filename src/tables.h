@@ -0,0 +1,48 @@
+#pragma once
+
+#include <SDL.h>
+#include <array>
+#include "fixed.h"
+
+// Binary angle: the full circle is the 32-bit range.
+using angle_t = Uint32;
+
+static constexpr angle_t ang45{0x20000000};
+static constexpr angle_t ang90{0x40000000};
+static constexpr angle_t ang180{0x80000000};
+static constexpr angle_t ang270{0xc0000000};
+
+// Angles are looked up in the trig tables at a coarser resolution.
+static constexpr int fine_angles{8192};
+static constexpr int fine_mask{fine_angles - 1};
+static constexpr int angle_to_fine_shift{19};
+
+// Slopes are looked up in tantoangle with this many steps from 0 to 1.
+static constexpr int slope_range{2048};
+static constexpr int slope_bits{11};
+
+// The tables are generated at compile time, so they need no setup.
+
+// Sine of every fine angle. The table spans 5/4 of a circle, so that the
+// cosine can be read from it a quarter circle ahead.
+extern const std::array<fixed_t, fine_angles * 5 / 4> finesine;
+
+// Tangent of the fine angles of the half circle from -90 to 90 degrees.
+extern const std::array<fixed_t, fine_angles / 2> finetangent;
+
+// Angle of every slope from 0 to 1, in steps of 1 / slope_range.
+extern const std::array<angle_t, slope_range + 1> tantoangle;
+
+inline fixed_t fineSine(const angle_t angle) {
+    return finesine[angle >> angle_to_fine_shift];
+}
+
+inline fixed_t fineCosine(const angle_t angle) {
+    return finesine[(angle >> angle_to_fine_shift) + fine_angles / 4];
+}
+
+// Index into tantoangle of the slope num / den, for 0 <= num <= den.
+int slopeDiv(Uint32 num, Uint32 den);
+
+// Angle of the vector (x, y) from the x axis.
+angle_t pointToAngle(fixed_t x, fixed_t y);
@@ -0,0 +1,351 @@
+#include "textures.h"
+#include "lump.h"
+#include "workers.h"
+#include <algorithm>
+#include <atomic>
+#include <format>
+
+using std::domain_error;
+using std::optional;
+using std::span;
+using std::string;
+using std::string_view;
+using std::vector;
+
+// Posts of a patch column end with this top delta.
+static constexpr Uint8 end_of_column{0xff};
+
+// Bytes before the texels of a post: top delta, length and padding.
+static constexpr Uint32 post_header_size{3};
+
+// Rows after which the drawers wrap texture columns around.
+static constexpr int wrap_height{128};
+
+// Composite textures are padded so that the drawers never read past the
+// buffer on short textures.
+static constexpr size_t composite_padding{wrap_height};
+
+
+struct TextureDef {
+    string name;
+    int width;
+    int height;
+    vector<TexturePatch> patches;
+};
+
+static string toUpper(const string_view name) {
+    string upper{name};
+    for (auto& c : upper) {
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    return upper;
+}
+
+static void readTextureDefs(
+    const vector<Uint8>& lump,
+    const size_t num_patches,
+    vector<TextureDef>& defs
+) {
+    LumpReader reader{lump};
+    const auto num_textures{reader.readInt()};
+    if (num_textures < 0) {
+        throw domain_error{"Texture lump contains invalid number of textures"};
+    }
+    vector<Sint32> offsets(num_textures);
+    for (auto& offset : offsets) {
+        offset = reader.readInt();
+    }
+    for (const auto offset : offsets) {
+        reader.seek(offset);
+        TextureDef def{};
+        def.name = toUpper(reader.readString(8));
+        [[maybe_unused]] const auto masked{reader.readInt()};
+        def.width = reader.readShort();
+        def.height = reader.readShort();
+        [[maybe_unused]] const auto column_directory{reader.readInt()};
+        const auto patch_count{reader.readShort()};
+        if (def.width <= 0 || def.height <= 0 || patch_count <= 0) {
+            const auto error{
+                std::format("Texture \"{}\" has invalid dimensions", def.name)
+            };
+            throw domain_error{error};
+        }
+        def.patches.reserve(patch_count);
+        for (Sint16 i = 0; i < patch_count; i++) {
+            TexturePatch patch{};
+            patch.origin_x = reader.readShort();
+            patch.origin_y = reader.readShort();
+            patch.patch = reader.readShort();
+            [[maybe_unused]] const auto step_dir{reader.readShort()};
+            [[maybe_unused]] const auto colormap{reader.readShort()};
+            if (patch.patch < 0
+                || static_cast<size_t>(patch.patch) >= num_patches) {
+                const auto error{
+                    std::format("Texture \"{}\" uses invalid patch", def.name)
+                };
+                throw domain_error{error};
+            }
+            def.patches.push_back(patch);
+        }
+        defs.push_back(std::move(def));
+    }
+}
+
+static int widthMask(const int width) {
+    int mask{1};
+    while (mask * 2 <= width) {
+        mask *= 2;
+    }
+    return mask - 1;
+}
+
+// Offsets of the columns of a patch, in the patch lump.
+static vector<Uint32> readColumnOffsets(const span<const Uint8> patch) {
+    LumpReader reader{patch};
+    const auto width{reader.readShort()};
+    [[maybe_unused]] const auto height{reader.readShort()};
+    [[maybe_unused]] const auto left_offset{reader.readShort()};
+    [[maybe_unused]] const auto top_offset{reader.readShort()};
+    if (width <= 0) {
+        throw domain_error{"Patch has invalid width"};
+    }
+    vector<Uint32> offsets(width);
+    for (auto& offset : offsets) {
+        offset = static_cast<Uint32>(reader.readInt());
+        if (offset >= patch.size()) {
+            throw domain_error{"Patch has invalid column offset"};
+        }
+    }
+    return offsets;
+}
+
+// Copy the posts of a patch column into a texture column.
+static void drawPatchColumn(
+    const span<const Uint8> patch,
+    const Uint32 column_ofs,
+    const int origin_y,
+    Uint8* dest,
+    const int height
+) {
+    LumpReader reader{patch};
+    reader.seek(column_ofs);
+    while (true) {
+        const auto top_delta{reader.readByte()};
+        if (top_delta == end_of_column) {
+            break;
+        }
+        const int length{reader.readByte()};
+        [[maybe_unused]] const auto padding{reader.readByte()};
+        const auto post{reader.readSpan(length)};
+        [[maybe_unused]] const auto end_padding{reader.readByte()};
+
+        // Clip the post to the texture.
+        auto position{origin_y + top_delta};
+        auto first{0};
+        auto count{length};
+        if (position < 0) {
+            first = -position;
+            count += position;
+            position = 0;
+        }
+        count = std::min(count, height - position);
+        if (count > 0) {
+            std::copy_n(post.begin() + first, count, dest + position);
+        }
+    }
+}
+
+// Referenced patch columns are read as far as the drawers wrap, which
+// the padding of the cached lump leaves room for even from a column that
+// starts at its end.
+static_assert(post_header_size + wrap_height <= cached_lump_padding);
+
+
+TextureManager::TextureManager(WadManager& wad_manager)
+    : wad_manager{wad_manager}
+    , arena{wad_manager.getZone(), ZoneTag::Static} {
+    loadPatchNames();
+
+    vector<TextureDef> defs{};
+    for (const auto lump_name : {"TEXTURE1", "TEXTURE2"}) {
+        // Only the registered and retail versions have TEXTURE2.
+        if (wad_manager.hasLump(lump_name)) {
+            const auto lump{wad_manager.getLumpData(lump_name)};
+            readTextureDefs(lump, patch_lumps.size(), defs);
+        }
+    }
+
+    textures = vector<Texture>(defs.size());
+    texture_map.reserve(defs.size());
+    for (size_t i = 0; i < defs.size(); i++) {
+        auto& texture{textures[i]};
+        texture.name = std::move(defs[i].name);
+        texture.width = defs[i].width;
+        texture.height = defs[i].height;
+        texture.width_mask = widthMask(texture.width);
+        const auto patches{allocate<TexturePatch>(defs[i].patches.size())};
+        std::ranges::copy(defs[i].patches, patches.begin());
+        texture.patches = patches;
+        for (const auto& texture_patch : texture.patches) {
+            if (!patch_lumps[texture_patch.patch]) {
+                const auto error{std::format(
+                    "Texture \"{}\" uses a missing patch", texture.name
+                )};
+                throw domain_error{error};
+            }
+        }
+        // Textures in TEXTURE2 do not override those in TEXTURE1.
+        texture_map.try_emplace(texture.name, static_cast<Sint32>(i));
+    }
+}
+
+template <typename T>
+span<T> TextureManager::allocate(const size_t count) {
+    std::lock_guard lock{arena_mutex};
+    return arena.allocateArray<T>(count);
+}
+
+void TextureManager::loadPatchNames() {
+    const auto lump{wad_manager.getLumpData("PNAMES")};
+    LumpReader reader{lump};
+    const auto num_patches{reader.readInt()};
+    if (num_patches < 0) {
+        throw domain_error{"PNAMES contains invalid number of patches"};
+    }
+    patch_lumps.reserve(num_patches);
+    for (Sint32 i = 0; i < num_patches; i++) {
+        const auto name{toUpper(reader.readString(8))};
+        // A missing patch is only an error if a texture uses it.
+        if (wad_manager.hasLump(name)) {
+            patch_lumps.emplace_back(wad_manager.getLumpIndex(name));
+        } else {
+            patch_lumps.emplace_back(std::nullopt);
+        }
+    }
+    patch_data.resize(num_patches);
+}
+
+span<const Uint8> TextureManager::loadPatch(const int patch) {
+    std::lock_guard lock{patch_mutex};
+    auto& data{patch_data[patch]};
+    if (data.empty()) {
+        data = wad_manager.cacheLumpData(*patch_lumps[patch]);
+    }
+    return data;
+}
+
+void TextureManager::buildTexture(Texture& texture) {
+    if (!referencePatch(texture)) {
+        compositeTexture(texture);
+    }
+}
+
+bool TextureManager::referencePatch(Texture& texture) {
+    // As in the original, every column of a single patch texture is drawn
+    // straight from the patch, from the texels of its first post on,
+    // whether the column is one solid post or has holes. Shorter textures
+    // are drawn past their height, up to the wrap, which only a padded
+    // composite has room for.
+    if (texture.patches.size() != 1 || texture.height < wrap_height) {
+        return false;
+    }
+    const auto& texture_patch{texture.patches.front()};
+    if (texture_patch.origin_y != 0) {
+        return false;
+    }
+    const auto patch{loadPatch(texture_patch.patch)};
+    const auto patch_columns{readColumnOffsets(patch)};
+    const auto first{-texture_patch.origin_x};
+    const auto last{first + texture.width};
+    if (first < 0 || last > static_cast<int>(patch_columns.size())) {
+        return false;
+    }
+
+    texture.data = patch.data();
+    texture.posts = true;
+    texture.column_ofs = allocate<Uint32>(texture.width);
+    for (int x = 0; x < texture.width; x++) {
+        texture.column_ofs[x] = patch_columns[first + x] + post_header_size;
+    }
+    return true;
+}
+
+void TextureManager::compositeTexture(Texture& texture) {
+    const auto height{static_cast<size_t>(texture.height)};
+    const auto composite{
+        allocate<Uint8>(texture.width * height + composite_padding)
+    };
+    texture.column_ofs = allocate<Uint32>(texture.width);
+    for (int x = 0; x < texture.width; x++) {
+        texture.column_ofs[x] = static_cast<Uint32>(x * height);
+    }
+
+    for (const auto& texture_patch : texture.patches) {
+        const auto patch{loadPatch(texture_patch.patch)};
+        const auto patch_columns{readColumnOffsets(patch)};
+        const auto patch_width{static_cast<int>(patch_columns.size())};
+        const auto first{std::max(texture_patch.origin_x, 0)};
+        const auto last{
+            std::min(texture_patch.origin_x + patch_width, texture.width)
+        };
+        for (auto x = first; x < last; x++) {
+            const auto column{patch_columns[x - texture_patch.origin_x]};
+            const auto dest{&composite[texture.column_ofs[x]]};
+            drawPatchColumn(
+                patch, column, texture_patch.origin_y, dest, texture.height
+            );
+        }
+    }
+    texture.data = composite.data();
+}
+
+optional<Sint32> TextureManager::searchTexture(const string_view name) const {
+    const auto texture{texture_map.find(toUpper(name))};
+    if (texture == texture_map.end()) {
+        return std::nullopt;
+    }
+    return texture->second;
+}
+
+Sint32 TextureManager::getTextureIndex(const string_view name) const {
+    if (const auto texture{searchTexture(name)}) {
+        return *texture;
+    }
+    const auto error{std::format("Could not find texture \"{}\"", name)};
+    throw domain_error{error};
+}
+
+const Texture& TextureManager::getTexture(const Sint32 texture) const {
+    if (texture < 0 || static_cast<size_t>(texture) >= textures.size()) {
+        throw domain_error{"No valid texture index"};
+    }
+    return textures[texture];
+}
+
+const Uint8* TextureManager::getColumn(const Sint32 texture, const int column) {
+    auto& tex{textures[texture]};
+    std::call_once(tex.built, [this, &tex] { buildTexture(tex); });
+    return tex.data + tex.column_ofs[column & tex.width_mask];
+}
+
+void TextureManager::warm(
+    const std::span<const Sint32> texture_list,
+    WorkerGroup& workers
+) {
+    // Reading lumps is serialized anyway, so load every patch first and
+    // leave only the compositing to the workers.
+    for (const auto texture : texture_list) {
+        for (const auto& texture_patch : getTexture(texture).patches) {
+            loadPatch(texture_patch.patch);
+        }
+    }
+    std::atomic<size_t> next{0};
+    workers.run([this, &next, texture_list](size_t) {
+        for (auto i{next++}; i < texture_list.size(); i = next++) {
+            auto& texture{textures[texture_list[i]]};
+            std::call_once(texture.built, [this, &texture] {
+                buildTexture(texture);
+            });
+        }
+    });
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <SDL.h>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "wad.h"
+#include "zone.h"
+
+class WorkerGroup;
+
+// A patch placed on a texture, as listed in TEXTURE1/TEXTURE2.
+struct TexturePatch {
+    // Position of the patch's top left corner in the texture.
+    int origin_x;
+    int origin_y;
+
+    // Index of the patch in PNAMES.
+    int patch;
+};
+
+/**
+ * Wall texture, made of one or more patches. The column data is only
+ * built on first use: a texture at least 128 texels high drawn with a
+ * single patch covering it references the patch lump directly, solid or
+ * masked, and any other texture is composited into a column-major
+ * buffer. The patch list and column data live in the static zone.
+ */
+struct Texture {
+    std::string name;
+    int width{};
+    int height{};
+
+    // Largest power of two not greater than the width, minus one.
+    // Column numbers wrap around it, as in the original game.
+    int width_mask{};
+
+    std::span<const TexturePatch> patches{};
+
+    std::once_flag built{};
+
+    // Column x starts at data + column_ofs[x] and holds height texels.
+    // If posts is set, the columns are those of the patch, and the posts
+    // that tell which texels are transparent start 3 bytes before them.
+    const Uint8* data{};
+    bool posts{false};
+    std::span<Uint32> column_ofs{};
+};
+
+/**
+ * Wall textures defined by the TEXTURE1 and TEXTURE2 lumps, whose patch
+ * names are resolved through PNAMES. Lookups from multiple render
+ * threads are safe.
+ */
+class TextureManager {
+    WadManager& wad_manager;
+    // Textures are built by several threads at once, which take turns
+    // at allocating.
+    ZoneArena arena;
+    std::mutex arena_mutex{};
+    std::vector<std::optional<LumpIndex>> patch_lumps{};
+    // Patches are kept in the lump cache of the WadManager.
+    std::mutex patch_mutex{};
+    std::vector<std::span<const Uint8>> patch_data{};
+    std::vector<Texture> textures;
+    std::unordered_map<std::string, Sint32> texture_map{};
+
+    template <typename T>
+    std::span<T> allocate(size_t count);
+
+    void loadPatchNames();
+    std::span<const Uint8> loadPatch(int patch);
+    void buildTexture(Texture& texture);
+    bool referencePatch(Texture& texture);
+    void compositeTexture(Texture& texture);
+
+  public:
+    explicit TextureManager(WadManager& wad_manager);
+
+    [[nodiscard]]
+    size_t size() const {
+        return textures.size();
+    }
+
+    [[nodiscard]]
+    std::optional<Sint32> searchTexture(std::string_view name) const;
+
+    [[nodiscard]]
+    Sint32 getTextureIndex(std::string_view name) const;
+
+    [[nodiscard]]
+    const Texture& getTexture(Sint32 texture) const;
+
+    // Texels of a column, building the texture if not done yet.
+    [[nodiscard]]
+    const Uint8* getColumn(Sint32 texture, int column);
+
+    // Build the given textures up front, e.g. those referenced by a
+    // level when it is loaded, spreading the work over the workers.
+    void warm(std::span<const Sint32> texture_list, WorkerGroup& workers);
+};
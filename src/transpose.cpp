@@ -0,0 +1,96 @@
+#include "transpose.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TRANSPOSE_SSE2
+#endif
+
+static constexpr int block_size{16};
+
+
+static void transposeScalar(
+    const Uint8* src,
+    const int src_pitch,
+    Uint8* dst,
+    const int dst_pitch,
+    const int width,
+    const int height
+) {
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            dst[y * dst_pitch + x] = src[x * src_pitch + y];
+        }
+    }
+}
+
+#ifdef TRANSPOSE_SSE2
+static void transposeBlock(
+    const Uint8* src,
+    const int src_pitch,
+    Uint8* dst,
+    const int dst_pitch
+) {
+    __m128i rows[block_size];
+    for (int i = 0; i < block_size; i++) {
+        const auto column{src + i * src_pitch};
+        rows[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column));
+    }
+
+    // Interleaving the bytes of row i with row i + 8 four times in a row
+    // is a perfect shuffle of the 16x16 block, i.e. its transpose.
+    for (int pass = 0; pass < 4; pass++) {
+        __m128i shuffled[block_size];
+        for (int i = 0; i < block_size / 2; i++) {
+            const auto lo{rows[i]};
+            const auto hi{rows[i + block_size / 2]};
+            shuffled[2 * i] = _mm_unpacklo_epi8(lo, hi);
+            shuffled[2 * i + 1] = _mm_unpackhi_epi8(lo, hi);
+        }
+        for (int i = 0; i < block_size; i++) {
+            rows[i] = shuffled[i];
+        }
+    }
+
+    for (int i = 0; i < block_size; i++) {
+        const auto row{dst + i * dst_pitch};
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row), rows[i]);
+    }
+}
+#endif
+
+void transposeToRows(
+    const Uint8* src,
+    const int src_pitch,
+    Uint8* dst,
+    const int dst_pitch,
+    const int width,
+    const int height
+) {
+#ifdef TRANSPOSE_SSE2
+    const auto blocks_w{width - width % block_size};
+    const auto blocks_h{height - height % block_size};
+    for (int y = 0; y < blocks_h; y += block_size) {
+        for (int x = 0; x < blocks_w; x += block_size) {
+            const auto block_src{src + x * src_pitch + y};
+            const auto block_dst{dst + y * dst_pitch + x};
+            transposeBlock(block_src, src_pitch, block_dst, dst_pitch);
+        }
+    }
+
+    // Right and bottom edges that do not fill a whole block.
+    const auto rest_w{width - blocks_w};
+    const auto rest_h{height - blocks_h};
+    transposeScalar(
+        src + blocks_w * src_pitch, src_pitch,
+        dst + blocks_w, dst_pitch,
+        rest_w, blocks_h
+    );
+    transposeScalar(
+        src + blocks_h, src_pitch,
+        dst + blocks_h * dst_pitch, dst_pitch,
+        width, rest_h
+    );
+#else
+    transposeScalar(src, src_pitch, dst, dst_pitch, width, height);
+#endif
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <SDL.h>
+
+/**
+ * Copy a column-major 8-bit image into a row-major one. The source
+ * holds width columns of height pixels, src_pitch bytes apart, and the
+ * destination holds height rows of width pixels, dst_pitch bytes apart.
+ */
+void transposeToRows(
+    const Uint8* src,
+    int src_pitch,
+    Uint8* dst,
+    int dst_pitch,
+    int width,
+    int height
+);
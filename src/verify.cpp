@@ -0,0 +1,76 @@
+#include "verify.h"
+#include "demo.h"
+#include "game.h"
+#include "stats.h"
+#include "workers.h"
+#include <format>
+#include <ostream>
+
+using std::span;
+using std::string_view;
+using std::vector;
+
+
+static DemoResult verifyDemo(WadManager& wad_manager, const string_view name) {
+    DemoResult result{.name = std::string{name}};
+    try {
+        const auto demo{Demo::load(wad_manager, name)};
+        Game game{demo.getSettings(), wad_manager};
+        DesyncDetector desync_detector{demo};
+        Stopwatch stopwatch;
+        for (size_t tic = 0; tic < demo.getNumTics(); tic++) {
+            game.ticker(demo.getTic(tic));
+            if (!desync_detector.check(game)) {
+                break;
+            }
+        }
+        result.seconds = stopwatch.lap() / 1000.0;
+        result.tics = game.getTic();
+        result.has_state_hashes = !demo.getStateHashes().empty();
+        result.desync_tic = desync_detector.getDesyncTic();
+    } catch (const std::exception& e) {
+        result.error = e.what();
+    }
+    return result;
+}
+
+vector<DemoResult> verifyDemos(
+    WadManager& wad_manager,
+    const span<const string_view> demo_names,
+    WorkerGroup& workers
+) {
+    vector<DemoResult> results(demo_names.size());
+    WorkQueues queues{workers.size(), demo_names.size()};
+    workers.run([&](const size_t worker) {
+        while (const auto demo{queues.pop(worker)}) {
+            results[*demo] = verifyDemo(wad_manager, demo_names[*demo]);
+        }
+    });
+    return results;
+}
+
+void printResults(std::ostream& out, const span<const DemoResult> results) {
+    for (const auto& result : results) {
+        if (result.error) {
+            out << std::format("{}: error: {}\n", result.name, *result.error);
+            continue;
+        }
+        const auto tics{static_cast<double>(result.tics)};
+        const auto tics_per_second{
+            result.seconds > 0 ? tics / result.seconds : 0.0
+        };
+        std::string status{"in sync"};
+        if (result.desync_tic) {
+            status = std::format("desynced after tic {}", *result.desync_tic);
+        } else if (!result.has_state_hashes) {
+            status = "no state hashes to check";
+        }
+        out << std::format(
+            "{}: {} tics, {:.0f} tics/sec, {}\n",
+            result.name,
+            result.tics,
+            tics_per_second,
+            status
+        );
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <SDL.h>
+#include <iosfwd>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class WadManager;
+class WorkerGroup;
+
+// Outcome of playing back one demo.
+struct DemoResult {
+    std::string name;
+    size_t tics{};
+    double seconds{};
+    bool has_state_hashes{false};
+    std::optional<Uint32> desync_tic{};
+    // Why the demo could not be played, if it could not.
+    std::optional<std::string> error{};
+
+    [[nodiscard]]
+    bool passed() const {
+        return !error && !desync_tic;
+    }
+};
+
+/**
+ * Play back every demo without rendering, each in its own game, spread
+ * over the workers. The WadManager is shared by all of them, and must
+ * not be used by anything else meanwhile.
+ */
+std::vector<DemoResult> verifyDemos(
+    WadManager& wad_manager,
+    std::span<const std::string_view> demo_names,
+    WorkerGroup& workers
+);
+
+// One line per demo, with its speed and whether it stayed in sync.
+void printResults(std::ostream& out, std::span<const DemoResult> results);
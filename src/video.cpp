@@ -0,0 +1,60 @@
+#include "video.h"
+#include "args.h"
+#include <format>
+
+using std::domain_error;
+
+// Largest render buffer supported, large enough for 8K displays.
+static constexpr int max_width{7680};
+static constexpr int max_height{4320};
+
+
+static int correctAspect(const int height) {
+    return (height * 6 + 4) / 5;
+}
+
+static int widescreenWidth(const int height) {
+    // Width of a 16:9 area once the vertical axis is aspect corrected,
+    // rounded to a multiple of 4 so that surface rows need no padding.
+    const auto width{correctAspect(height) * 16 / 9};
+    return (width + 2) & ~3;
+}
+
+VideoMode::VideoMode(const int width, const int height)
+    : width{width}
+    , height{height}
+    , window_width{width}
+    , window_height{correctAspect(height)} {
+    if (width < native_width || width > max_width) {
+        const auto error{std::format("Invalid render width {}", width)};
+        throw domain_error{error};
+    }
+    if (height < native_height || height > max_height) {
+        const auto error{std::format("Invalid render height {}", height)};
+        throw domain_error{error};
+    }
+}
+
+VideoMode VideoMode::fromArguments(const Arguments& args) {
+    const auto scale{args.getInt("-scale").value_or(1)};
+    if (scale < 1) {
+        const auto error{std::format("Invalid render scale {}", scale)};
+        throw domain_error{error};
+    }
+    const auto height{args.getInt("-height").value_or(native_height * scale)};
+    auto width{native_width * scale};
+    if (args.hasParam("-widescreen")) {
+        width = widescreenWidth(height);
+    }
+    width = args.getInt("-width").value_or(width);
+    VideoMode mode{width, height};
+    if (args.hasParam("-columnmajor")) {
+        mode.layout = FrameLayout::ColumnMajor;
+    }
+    mode.true_color = args.hasParam("-truecolor");
+    if (mode.true_color && mode.layout == FrameLayout::ColumnMajor) {
+        throw domain_error{"True color needs a row-major render buffer"};
+    }
+    mode.headless = args.hasParam("-headless");
+    return mode;
+}
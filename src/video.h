@@ -0,0 +1,85 @@
+#pragma once
+
+#include <SDL.h>
+
+class Arguments;
+
+// Size of the original 320x200 framebuffer. The original game was
+// displayed on 4:3 monitors, so pixels are 20% taller than they are wide.
+static constexpr int native_width{320};
+static constexpr int native_height{200};
+
+/**
+ * Memory order of the render buffer. Walls and sprites are drawn one
+ * column at a time, which a column-major buffer turns into contiguous
+ * writes; the buffer is then transposed to rows when presented.
+ */
+enum class FrameLayout {
+    RowMajor,
+    ColumnMajor,
+};
+
+/**
+ * Resolution the renderer draws at, and the logical size of the window
+ * the result is presented in. The logical size only differs from the
+ * render size by the aspect ratio correction of the vertical axis.
+ */
+struct VideoMode {
+    // Size of the internal render buffer, in pixels.
+    int width;
+    int height;
+
+    // Logical size the render buffer is scaled to when presented.
+    int window_width;
+    int window_height;
+
+    FrameLayout layout{FrameLayout::RowMajor};
+
+    // Draw ARGB8888 pixels instead of palette indices.
+    bool true_color{false};
+
+    // Render into the offscreen buffers only, without a window.
+    bool headless{false};
+
+    VideoMode(int width, int height);
+
+    /**
+     * Select the video mode from the command line:
+     * -scale <n>:           render at an integer multiple of 320x200.
+     * -width <w>:           render at an arbitrary width.
+     * -height <h>:          render at an arbitrary height.
+     * -widescreen:          derive the width from the height so that
+     *                       the view fills a 16:9 display.
+     * -columnmajor:         draw into a column-major render buffer.
+     * -truecolor:           draw in 32-bit color.
+     * -headless:            do not open a window.
+     * Without any of them the game renders at the native resolution.
+     */
+    [[nodiscard]]
+    static VideoMode fromArguments(const Arguments& args);
+};
+
+/**
+ * Buffer the renderer draws into, holding either 8-bit palette indices
+ * or ARGB8888 pixels. The pitch is the distance between rows, or between
+ * columns in a column-major buffer, in pixels. It can be larger than
+ * the row or column length due to padding.
+ */
+struct FrameBuffer {
+    Uint8* pixels;
+    int width;
+    int height;
+    int pitch;
+    FrameLayout layout{FrameLayout::RowMajor};
+    bool true_color{false};
+
+    template <typename Pixel>
+    [[nodiscard]]
+    Pixel* at(const int x, const int y) const {
+        const auto buffer{reinterpret_cast<Pixel*>(pixels)};
+        if (layout == FrameLayout::ColumnMajor) {
+            return &buffer[x * pitch + y];
+        }
+        return &buffer[y * pitch + x];
+    }
+};
@@ -0,0 +1,188 @@
+#include "wad.h"
+#include <algorithm>
+#include <format>
+
+using std::domain_error;
+using std::ifstream;
+using std::optional;
+using std::string;
+using std::string_view;
+using std::vector;
+using std::filesystem::path;
+
+
+WadReader::WadReader(const path& wad_file)
+    : wad{wad_file, std::ios::binary} {
+    wad.exceptions(ifstream::failbit | ifstream::badbit);
+}
+
+void WadReader::seek(const std::streamoff pos) {
+    wad.seekg(pos);
+}
+
+void WadReader::read(char* buffer, const std::streamsize count) {
+    wad.read(buffer, count);
+    if (wad.gcount() != count) {
+        const auto error{std::format("Failed to extract {} bytes", count)};
+        throw domain_error{error};
+    }
+}
+
+Sint32 WadReader::readInt() {
+    Sint32 i{};
+    read((char*) &i, sizeof(i));
+    return SDL_SwapLE32(i);
+}
+
+Sint16 WadReader::readShort() {
+    Sint16 i{};
+    read((char*) &i, sizeof(i));
+    return SDL_SwapLE16(i);
+}
+
+string WadReader::readString(const std::streamsize size) {
+    vector<char> buffer(size);
+    read(buffer.data(), size);
+    // Remove any trailing zeroes.
+    size_t i = 0;
+    for (; i < size; i++) {
+        if (buffer[i] == '\0') {
+            break;
+        }
+    }
+    return {buffer.data(), i};
+}
+
+
+WadHeader::WadHeader(WadReader& reader)
+    : id{reader.readString(4)}
+    , num_lumps{reader.readInt()}
+    , directory_ofs{reader.readInt()} {
+    if (id != "IWAD" && id != "PWAD") {
+        const auto error{"WAD contains invalid id"};
+        throw domain_error{error};
+    }
+    if (num_lumps <= 0) {
+        const auto error{"WAD contains invalid number of lumps"};
+        throw domain_error{error};
+    }
+    if (directory_ofs <= 0) {
+        const auto error{"WAD contains invalid directory offset"};
+        throw domain_error{error};
+    }
+}
+
+WadLump::WadLump(WadReader& reader)
+    : position{reader.readInt()}
+    , size{reader.readInt()}
+    , name{reader.readString(8)} {
+    if (position < 0) {
+        const auto error{
+            std::format("Lump \"{}\" contains invalid data offset!", name)
+        };
+        throw domain_error{error};
+    }
+    if (size < 0) {
+        const auto error{
+            std::format("Lump \"{}\" contains invalid size!", name)
+        };
+        throw domain_error{error};
+    }
+}
+
+WadDirectory::WadDirectory(WadReader& reader, const WadHeader& header) {
+    const auto num_lumps{header.num_lumps};
+    reader.seek(header.directory_ofs);
+    lumps.reserve(num_lumps);
+    lump_map.reserve(num_lumps);
+    for (Sint32 i = 0; i < num_lumps; i++) {
+        lumps.emplace_back(reader);
+        lump_map.try_emplace(lumps[i].name, i);
+    }
+}
+
+optional<Sint32> WadDirectory::searchLump(const string_view lump_name) const {
+    const auto lump_index{lump_map.find(lump_name)};
+    if (lump_index == lump_map.end()) {
+        return std::nullopt;
+    }
+    return lump_index->second;
+}
+
+const WadLump& WadDirectory::getLump(const Sint32 lump_index) const {
+    if (lump_index < 0 || lump_index >= lumps.size()) {
+        throw domain_error{"No valid lump index"};
+    }
+    return lumps[lump_index];
+}
+
+WadFile::WadFile(const path& wad_file)
+    : reader{wad_file}
+    , header{reader}
+    , directory{reader, header} {
+}
+
+vector<Uint8> WadFile::getLumpData(const Sint32 lump_index) {
+    vector<Uint8> lump_data(getLump(lump_index).size);
+    readLumpData(lump_index, lump_data);
+    return lump_data;
+}
+
+void WadFile::readLumpData(
+    const Sint32 lump_index,
+    std::span<Uint8> lump_data
+) {
+    const auto lump{getLump(lump_index)};
+    reader.seek(lump.position);
+    reader.read((char*) lump_data.data(), lump.size);
+}
+
+
+// Lumps are mostly small, so the cache grows in large chunks.
+static constexpr size_t cache_chunk_size{1024 * 1024};
+
+WadManager::WadManager(Zone& zone)
+    : zone{zone}
+    , cache_arena{zone, ZoneTag::Cache, cache_chunk_size} {
+}
+
+optional<LumpIndex> WadManager::searchLump(const string_view lump_name) const {
+    for (size_t i = 0; i < files.size(); i++) {
+        auto lump{files[i].searchLump(lump_name)};
+        if (lump.has_value()) {
+            return LumpIndex{i, *lump};
+        }
+    }
+    return std::nullopt;
+}
+
+LumpIndex WadManager::getLumpIndex(const string_view lump_name) const {
+    if (const auto lump_index{searchLump(lump_name)}) {
+        return *lump_index;
+    }
+    const auto error{std::format("Could not find lump \"{}\"", lump_name)};
+    throw domain_error{error};
+}
+
+vector<Uint8> WadManager::getLumpData(const LumpIndex& lump_index) {
+    WadFile& wad{files[lump_index.wad]};
+    const auto lump{lump_index.lump};
+    return wad.getLumpData(lump);
+}
+
+std::span<const Uint8> WadManager::cacheLumpData(const LumpIndex& lump_index) {
+    const std::scoped_lock lock{cache_mutex};
+    const std::pair key{lump_index.wad, lump_index.lump};
+    auto cached{lump_cache.find(key)};
+    if (cached == lump_cache.end()) {
+        auto& wad{files[lump_index.wad]};
+        const auto size{static_cast<size_t>(wad.getLump(lump_index.lump).size)};
+        const auto padded_size{size + cached_lump_padding};
+        const auto data{cache_arena.allocate<Uint8>(padded_size)};
+        const std::span lump_data{data, size};
+        wad.readLumpData(lump_index.lump, lump_data);
+        std::fill_n(data + size, cached_lump_padding, Uint8{0});
+        cached = lump_cache.emplace(key, lump_data).first;
+    }
+    return cached->second;
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <SDL.h>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <span>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "zone.h"
+
+class WadReader {
+    std::ifstream wad;
+
+  public:
+    explicit WadReader(const std::filesystem::path& wad_file);
+
+    WadReader(WadReader&& other) noexcept = default;
+
+    void seek(std::streamoff pos);
+
+    void read(char* buffer, std::streamsize count);
+
+    Sint32 readInt();
+
+    Sint16 readShort();
+
+    std::string readString(std::streamsize size);
+};
+
+
+struct WadHeader {
+    // The ASCII characters "IWAD" or "PWAD".
+    std::string id;
+
+    // An integer specifying the number of lumps in the WAD.
+    Sint32 num_lumps;
+
+    // An integer holding a pointer to the location of the directory.
+    Sint32 directory_ofs;
+
+    explicit WadHeader(WadReader& reader);
+};
+
+struct WadLump {
+    // An integer holding a pointer to the start of the lump's data in the file.
+    Sint32 position;
+
+    // An integer representing the size of the lump in bytes.
+    Sint32 size;
+
+    // An ASCII string defining the lump's name. The name has a limit
+    // of 8 characters, the same as the main portion of an MS-DOS filename.
+    std::string name;
+
+    explicit WadLump(WadReader& reader);
+
+    [[nodiscard]]
+    bool isMarker() const {
+        return size == 0;
+    }
+};
+
+class WadDirectory {
+    std::vector<WadLump> lumps{};
+    std::unordered_map<std::string_view, Sint32> lump_map{};
+
+  public:
+    WadDirectory(WadReader& reader, const WadHeader& header);
+
+    WadDirectory(WadDirectory&& other) noexcept = default;
+
+    [[nodiscard]]
+    std::optional<Sint32> searchLump(std::string_view lump_name) const;
+
+    [[nodiscard]]
+    const WadLump& getLump(Sint32 lump_index) const;
+};
+
+/**
+ * A WAD file consists of a header, a directory, and the data lumps
+ * that make up the resources stored within the file. A WAD file can
+ * be of two types:
+ * - IWAD: An "Internal WAD" (or "Initial WAD"), or a core WAD that is
+ *   loaded automatically by the engine and generally provides all the
+ *   data required to run the game.
+ * - PWAD: A "Patch WAD", or an optional file that replaces data from
+ *   the IWAD loaded or provides additional data to the engine.
+ */
+class WadFile {
+    WadReader reader;
+    WadHeader header;
+    WadDirectory directory;
+
+  public:
+    explicit WadFile(const std::filesystem::path& wad_file);
+
+    WadFile(WadFile&& other) noexcept = default;
+
+    [[nodiscard]]
+    std::optional<Sint32> searchLump(std::string_view lump_name) const {
+        return directory.searchLump(lump_name);
+    }
+
+    [[nodiscard]]
+    const WadLump& getLump(const Sint32 lump_index) const {
+        return directory.getLump(lump_index);
+    }
+
+    [[nodiscard]]
+    std::vector<Uint8> getLumpData(Sint32 lump_index);
+
+    // Read the data of a lump into a buffer of the lump's size.
+    void readLumpData(Sint32 lump_index, std::span<Uint8> lump_data);
+};
+
+
+struct LumpIndex {
+    size_t wad;
+    Sint32 lump;
+
+    LumpIndex(const size_t wad, const Sint32 lump)
+        : wad{wad}
+        , lump{lump} {
+    }
+
+    friend LumpIndex operator+(const LumpIndex& index, const Sint32& inc) {
+        return {index.wad, index.lump + inc};
+    }
+
+    friend LumpIndex operator+(const Sint32& inc, const LumpIndex& index) {
+        return index + inc;
+    }
+};
+
+// Zero bytes after every cached lump, so that the drawers can read a
+// whole column of a patch from any of its columns, as the original did.
+static constexpr size_t cached_lump_padding{256};
+
+class WadManager {
+    Zone& zone;
+    std::vector<WadFile> files{};
+
+    // Lumps loaded once and kept for the lifetime of the manager, shared
+    // by every thread that reads them.
+    ZoneArena cache_arena;
+    std::map<std::pair<size_t, Sint32>, std::span<const Uint8>> lump_cache{};
+    std::mutex cache_mutex{};
+
+    [[nodiscard]]
+    std::optional<LumpIndex> searchLump(std::string_view lump_name) const;
+
+  public:
+    // Cached lumps are allocated in the zone.
+    explicit WadManager(Zone& zone);
+
+    WadManager(WadManager& other) = delete;
+    WadManager& operator=(const WadManager& other) = delete;
+
+    [[nodiscard]]
+    Zone& getZone() const {
+        return zone;
+    }
+
+    void addWad(const std::filesystem::path& wad_file) {
+        files.emplace_back(wad_file);
+    }
+
+    [[nodiscard]]
+    bool hasLump(const std::string_view lump_name) const {
+        return searchLump(lump_name) != std::nullopt;
+    }
+
+    [[nodiscard]]
+    LumpIndex getLumpIndex(std::string_view lump_name) const;
+
+    [[nodiscard]]
+    std::vector<Uint8> getLumpData(const LumpIndex& lump_index);
+
+    [[nodiscard]]
+    std::vector<Uint8> getLumpData(std::string_view lump_name) {
+        const auto lump_index{getLumpIndex(lump_name)};
+        return getLumpData(lump_index);
+    }
+
+    /**
+     * Data of a lump, read from the WAD the first time it is requested
+     * and cached afterwards. Unlike getLumpData(), this can be called
+     * from several threads at once.
+     */
+    [[nodiscard]]
+    std::span<const Uint8> cacheLumpData(const LumpIndex& lump_index);
+};
@@ -1,19 +1,21 @@
 #include "window.h"
 #include "config.h"
+#include "transpose.h"
 #include <format>
 
 using std::domain_error;
 
-#define WINDOW_WIDTH  (320)
-#define WINDOW_HEIGHT (240)
-
-#define BUFFER_WIDTH  WINDOW_WIDTH
-#define BUFFER_HEIGHT (200)
-
 static constexpr Uint32 pixel_format{SDL_PIXELFORMAT_ARGB8888};
 
+// Columns of the column-major buffer are padded to a whole number of
+// 16 pixel blocks, the unit the transpose works on.
+static constexpr int column_alignment{16};
 
-static SDL_Window* createWindow() {
+
+static SDL_Window* createWindow(const VideoMode& mode) {
+    if (mode.headless) {
+        return nullptr;
+    }
     const auto title{PACKAGE_STRING};
     constexpr int x{SDL_WINDOWPOS_CENTERED};
     constexpr int y{SDL_WINDOWPOS_CENTERED};
@@ -29,11 +31,17 @@ static SDL_Window* createWindow() {
         };
         throw domain_error{error};
     }
-    SDL_SetWindowMinimumSize(window, WINDOW_WIDTH, WINDOW_HEIGHT);
+    const VideoMode native_mode{native_width, native_height};
+    const auto min_w{native_mode.window_width};
+    const auto min_h{native_mode.window_height};
+    SDL_SetWindowMinimumSize(window, min_w, min_h);
     return window;
 }
 
-static SDL_Renderer* createRenderer(SDL_Window* window) {
+static SDL_Renderer* createRenderer(
+    SDL_Window* window,
+    const VideoMode& mode
+) {
     if (!window) {
         return nullptr;
     }
@@ -45,7 +53,7 @@ static SDL_Renderer* createRenderer(SDL_Window* window) {
     // Important: Set the "logical size" of the rendering context. At the same
     // time this also defines the aspect ratio that is preserved while scaling
     // and stretching the texture into the window.
-    SDL_RenderSetLogicalSize(renderer, WINDOW_WIDTH, WINDOW_HEIGHT);
+    SDL_RenderSetLogicalSize(renderer, mode.window_width, mode.window_height);
 
     // Blank out the full screen area in case there is any junk in
     // the borders that won't otherwise be overwritten.
@@ -56,10 +64,10 @@ static SDL_Renderer* createRenderer(SDL_Window* window) {
     return renderer;
 }
 
-static SDL_Surface* createScreenBuffer() {
+static SDL_Surface* createScreenBuffer(const VideoMode& mode) {
     constexpr Uint32 flags{};
-    constexpr int w{BUFFER_WIDTH};
-    constexpr int h{BUFFER_HEIGHT};
+    const int w{mode.width};
+    const int h{mode.height};
     constexpr int depth{8};
     constexpr Uint32 r{};
     constexpr Uint32 g{};
@@ -74,10 +82,10 @@ static SDL_Surface* createScreenBuffer() {
     return screen_buffer;
 }
 
-static SDL_Surface* createArgbBuffer() {
+static SDL_Surface* createArgbBuffer(const VideoMode& mode) {
     constexpr Uint32 flags{};
-    constexpr int w{BUFFER_WIDTH};
-    constexpr int h{BUFFER_HEIGHT};
+    const int w{mode.width};
+    const int h{mode.height};
     Uint32 r{};
     Uint32 g{};
     Uint32 b{};
@@ -91,23 +99,37 @@ static SDL_Surface* createArgbBuffer() {
     return argb_buffer;
 }
 
-static SDL_Texture* createTexture(SDL_Renderer* renderer) {
+static SDL_Texture* createTexture(
+    SDL_Renderer* renderer,
+    const VideoMode& mode
+) {
     if (!renderer) {
         return nullptr;
     }
     constexpr int access{SDL_TEXTUREACCESS_STREAMING};
-    constexpr int w{BUFFER_WIDTH};
-    constexpr int h{BUFFER_HEIGHT};
+    const int w{mode.width};
+    const int h{mode.height};
     const auto texture{SDL_CreateTexture(renderer, pixel_format, access, w, h)};
     return texture;
 }
 
-Window::Window()
-    : window{createWindow()}
-    , renderer{createRenderer(window)}
-    , screen_buffer{createScreenBuffer()}
-    , argb_buffer{createArgbBuffer()}
-    , texture{createTexture(renderer)} {
+static int columnPitch(const VideoMode& mode) {
+    if (mode.layout != FrameLayout::ColumnMajor) {
+        return 0;
+    }
+    const auto padding{column_alignment - 1};
+    return (mode.height + padding) / column_alignment * column_alignment;
+}
+
+Window::Window(const VideoMode& mode)
+    : mode{mode}
+    , window{createWindow(mode)}
+    , renderer{createRenderer(window, mode)}
+    , screen_buffer{createScreenBuffer(mode)}
+    , argb_buffer{createArgbBuffer(mode)}
+    , texture{createTexture(renderer, mode)}
+    , column_buffer(columnPitch(mode) * mode.width)
+    , column_pitch{columnPitch(mode)} {
 }
 
 Window::~Window() {
@@ -122,3 +144,77 @@ Window::~Window() {
     renderer = nullptr;
     window = nullptr;
 }
+
+FrameBuffer Window::getFrameBuffer() {
+    if (mode.layout == FrameLayout::ColumnMajor) {
+        auto pixels{column_buffer.data()};
+        const auto layout{FrameLayout::ColumnMajor};
+        return {pixels, mode.width, mode.height, column_pitch, layout};
+    }
+    if (mode.true_color) {
+        auto pixels{static_cast<Uint8*>(argb_buffer->pixels)};
+        const auto pitch{argb_buffer->pitch / static_cast<int>(sizeof(Uint32))};
+        const auto layout{FrameLayout::RowMajor};
+        return {pixels, mode.width, mode.height, pitch, layout, true};
+    }
+    auto pixels{static_cast<Uint8*>(screen_buffer->pixels)};
+    return {pixels, mode.width, mode.height, screen_buffer->pitch};
+}
+
+void Window::setPalette(const Uint8* palette) {
+    SDL_Color colors[256];
+    for (auto& color : colors) {
+        color.r = *palette++;
+        color.g = *palette++;
+        color.b = *palette++;
+        color.a = 255;
+    }
+    SDL_SetPaletteColors(screen_buffer->format->palette, colors, 0, 256);
+}
+
+void Window::present() {
+    const SDL_Rect screen{0, 0, mode.width, mode.height};
+    present({&screen, 1});
+}
+
+void Window::present(const std::span<const SDL_Rect> regions) {
+    const auto screen_pixels{static_cast<Uint8*>(screen_buffer->pixels)};
+    const auto screen_pitch{screen_buffer->pitch};
+    const auto argb_pixels{static_cast<Uint8*>(argb_buffer->pixels)};
+    const auto argb_pitch{argb_buffer->pitch};
+    for (const auto& region : regions) {
+        if (mode.layout == FrameLayout::ColumnMajor) {
+            transposeToRows(
+                &column_buffer[region.x * column_pitch + region.y],
+                column_pitch,
+                &screen_pixels[region.y * screen_pitch + region.x],
+                screen_pitch,
+                region.w, region.h
+            );
+        }
+
+        // Blit from the paletted 8-bit screen buffer to the intermediate
+        // 32-bit buffer, which is then uploaded to the streaming texture.
+        // In true color the renderer draws into the 32-bit buffer
+        // directly.
+        if (!mode.true_color) {
+            SDL_Rect src_rect{region};
+            SDL_Rect dst_rect{region};
+            SDL_BlitSurface(screen_buffer, &src_rect, argb_buffer, &dst_rect);
+        }
+        if (texture) {
+            const auto offset{region.y * argb_pitch + region.x * 4};
+            const auto pixels{&argb_pixels[offset]};
+            SDL_UpdateTexture(texture, &region, pixels, argb_pitch);
+        }
+    }
+    if (!renderer) {
+        return;
+    }
+
+    // The renderer scales the texture to the logical size of the window,
+    // so the aspect ratio correction happens on the GPU.
+    SDL_RenderClear(renderer);
+    SDL_RenderCopy(renderer, texture, nullptr, nullptr);
+    SDL_RenderPresent(renderer);
+}
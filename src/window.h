@@ -1,17 +1,43 @@
 #pragma once
 
 #include <SDL.h>
+#include <span>
+#include <vector>
+#include "video.h"
 
 class Window {
+    VideoMode mode;
+
+    // The window, renderer and texture are null in headless mode.
     SDL_Window* window;
     SDL_Renderer* renderer;
     SDL_Surface* screen_buffer;
     SDL_Surface* argb_buffer;
     SDL_Texture* texture;
 
+    // Render buffer used instead of the screen buffer in column-major
+    // mode, transposed into the screen buffer when presented.
+    std::vector<Uint8> column_buffer;
+    int column_pitch;
+
 public:
-    Window();
+    explicit Window(const VideoMode& mode);
     Window(Window& other) = delete;
     ~Window();
     Window& operator=(const Window& other) = delete;
+
+    [[nodiscard]]
+    FrameBuffer getFrameBuffer();
+
+    // Load the 256 RGB triplets of a PLAYPAL palette.
+    void setPalette(const Uint8* palette);
+
+    // Convert the screen buffer to ARGB and show it on screen. Headless
+    // windows only do the conversion.
+    void present();
+
+    // Same as present(), but only the given regions of the screen buffer
+    // changed since the last frame, so only they are converted and
+    // uploaded to the texture.
+    void present(std::span<const SDL_Rect> regions);
 };
@@ -0,0 +1,69 @@
+#include "workers.h"
+#include <stdexcept>
+
+using std::domain_error;
+
+
+WorkerGroup::WorkerGroup(const size_t num_workers)
+    : start{static_cast<std::ptrdiff_t>(num_workers)}
+    , finish{static_cast<std::ptrdiff_t>(num_workers)} {
+    if (num_workers == 0) {
+        throw domain_error{"Worker group needs at least one worker"};
+    }
+    threads.reserve(num_workers - 1);
+    for (size_t i = 1; i < num_workers; i++) {
+        threads.emplace_back([this, i] { work(i); });
+    }
+}
+
+WorkerGroup::~WorkerGroup() {
+    quit = true;
+    start.arrive_and_wait();
+    // Threads are joined when the vector is destroyed.
+}
+
+void WorkerGroup::work(const size_t worker) {
+    while (true) {
+        start.arrive_and_wait();
+        if (quit) {
+            return;
+        }
+        job(worker);
+        finish.arrive_and_wait();
+    }
+}
+
+void WorkerGroup::run(std::function<void(size_t)> worker_job) {
+    job = std::move(worker_job);
+    start.arrive_and_wait();
+    job(0);
+    finish.arrive_and_wait();
+}
+
+
+WorkQueues::WorkQueues(const size_t num_queues, const size_t num_tasks)
+    : queues(num_queues) {
+    for (size_t task = 0; task < num_tasks; task++) {
+        queues[task % num_queues].tasks.push_back(task);
+    }
+}
+
+std::optional<size_t> WorkQueues::pop(const size_t worker) {
+    for (size_t i = 0; i < queues.size(); i++) {
+        auto& queue{queues[(worker + i) % queues.size()]};
+        const std::scoped_lock lock{queue.mutex};
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        size_t task{};
+        if (i == 0) {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+        } else {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+        }
+        return task;
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <barrier>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed group of threads that run the same job in lock step. The
+ * calling thread takes part as worker 0, so a group of one runs the
+ * job inline without any synchronization.
+ */
+class WorkerGroup {
+    std::function<void(size_t)> job{};
+    std::barrier<> start;
+    std::barrier<> finish;
+    bool quit{false};
+    std::vector<std::jthread> threads{};
+
+    void work(size_t worker);
+
+  public:
+    explicit WorkerGroup(size_t num_workers);
+    WorkerGroup(WorkerGroup& other) = delete;
+    ~WorkerGroup();
+    WorkerGroup& operator=(const WorkerGroup& other) = delete;
+
+    [[nodiscard]]
+    size_t size() const {
+        return threads.size() + 1;
+    }
+
+    // Run job(worker) on every worker, returning once all are done.
+    void run(std::function<void(size_t)> worker_job);
+};
+
+/**
+ * Task queues for jobs made of independent tasks of uneven length, with
+ * one queue per worker. Workers take tasks from the back of their own
+ * queue, and once it is empty steal from the front of the others, so
+ * that no worker idles while tasks remain.
+ */
+class WorkQueues {
+    struct Queue {
+        std::mutex mutex{};
+        std::deque<size_t> tasks{};
+    };
+
+    std::vector<Queue> queues;
+
+  public:
+    // Deal tasks 0 to num_tasks - 1 out to the queues.
+    WorkQueues(size_t num_queues, size_t num_tasks);
+
+    // Next task for the worker, or nothing once all tasks are taken.
+    [[nodiscard]]
+    std::optional<size_t> pop(size_t worker);
+};
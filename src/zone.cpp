@@ -0,0 +1,97 @@
+#include "zone.h"
+#include <algorithm>
+#include <format>
+#include <ostream>
+
+
+void Zone::attach(ZoneArena* arena) {
+    const std::scoped_lock lock{arenas_mutex};
+    arenas.push_back(arena);
+}
+
+void Zone::detach(ZoneArena* arena) {
+    const std::scoped_lock lock{arenas_mutex};
+    std::erase(arenas, arena);
+}
+
+void Zone::replace(ZoneArena* from, ZoneArena* to) {
+    const std::scoped_lock lock{arenas_mutex};
+    std::ranges::replace(arenas, from, to);
+}
+
+ZoneStats Zone::getStats() const {
+    ZoneStats stats{};
+    const std::scoped_lock lock{arenas_mutex};
+    for (const auto arena : arenas) {
+        auto& tag_stats{stats[static_cast<size_t>(arena->getTag())]};
+        tag_stats.arenas++;
+        tag_stats.used += arena->getUsed();
+        tag_stats.reserved += arena->getReserved();
+    }
+    return stats;
+}
+
+
+ZoneArena::ZoneArena(Zone& zone, const ZoneTag tag, const size_t chunk_size)
+    : zone{&zone}
+    , tag{tag}
+    , arena{chunk_size}
+    , purge_count{zone.purge_count.load(std::memory_order_relaxed)} {
+    zone.attach(this);
+}
+
+ZoneArena::ZoneArena(ZoneArena&& other) noexcept
+    : zone{other.zone}
+    , tag{other.tag}
+    , arena{std::move(other.arena)}
+    , purge_count{other.purge_count} {
+    publish();
+    zone->replace(&other, this);
+    other.zone = nullptr;
+}
+
+ZoneArena::~ZoneArena() {
+    if (zone) {
+        zone->detach(this);
+    }
+}
+
+void ZoneArena::reset() {
+    const auto zone_purges{zone->purge_count.load(std::memory_order_relaxed)};
+    if (tag == ZoneTag::Purgable && purge_count != zone_purges) {
+        purge_count = zone_purges;
+        arena.release();
+    } else {
+        arena.reset();
+    }
+    publish();
+}
+
+
+const char* zoneTagName(const ZoneTag tag) {
+    switch (tag) {
+    case ZoneTag::Static:
+        return "static";
+    case ZoneTag::Level:
+        return "level";
+    case ZoneTag::Cache:
+        return "cache";
+    case ZoneTag::Purgable:
+        return "purgable";
+    }
+    return "unknown";
+}
+
+void printZoneStats(std::ostream& out, const ZoneStats& stats) {
+    for (size_t i = 0; i < stats.size(); i++) {
+        const auto& tag_stats{stats[i]};
+        out << std::format(
+            "{:<9} {:4} arenas {:10} bytes used {:10} reserved {:5.1f}% free\n",
+            zoneTagName(static_cast<ZoneTag>(i)),
+            tag_stats.arenas,
+            tag_stats.used,
+            tag_stats.reserved,
+            tag_stats.fragmentation() * 100.0
+        );
+    }
+}
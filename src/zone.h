@@ -0,0 +1,277 @@
+#pragma once
+
+#include <SDL.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include "arena.h"
+
+// What an allocation lives for, which decides when it is freed.
+enum class ZoneTag : Uint8 {
+    // For the whole run, such as lookup tables and texture definitions.
+    Static,
+    // Until the level it belongs to is left.
+    Level,
+    // Data read from the WADs, kept to avoid reading it again.
+    Cache,
+    // Scratch memory whose contents never outlive a reset, which gives
+    // its chunks back to the global heap after a purge.
+    Purgable,
+};
+
+static constexpr size_t num_zone_tags{4};
+
+// Memory held under one tag.
+struct ZoneTagStats {
+    size_t arenas;
+    // Bytes handed out, not counting padding.
+    size_t used;
+    // Bytes taken from the global heap.
+    size_t reserved;
+
+    // Share of the reserved bytes that is not in use.
+    [[nodiscard]]
+    double fragmentation() const {
+        return reserved == 0 ? 0.0 : 1.0 - double(used) / double(reserved);
+    }
+};
+
+using ZoneStats = std::array<ZoneTagStats, num_zone_tags>;
+
+class ZoneArena;
+
+/**
+ * The engine's heap, in which every allocation has a tag. Memory is
+ * handed out by arenas, each owned by whatever the memory belongs to and
+ * freed all at once when the owner resets or drops its arena, so that
+ * leaving a level frees everything of it in one go even while another
+ * level is being played on another thread. The zone keeps track of the
+ * arenas to report on the memory of each tag.
+ */
+class Zone {
+    std::vector<ZoneArena*> arenas{};
+    mutable std::mutex arenas_mutex{};
+    std::atomic<Uint32> purge_count{0};
+
+    friend class ZoneArena;
+
+    void attach(ZoneArena* arena);
+    void detach(ZoneArena* arena);
+    void replace(ZoneArena* from, ZoneArena* to);
+
+  public:
+    Zone() = default;
+
+    Zone(Zone& other) = delete;
+    Zone& operator=(const Zone& other) = delete;
+
+    // Make every purgable arena give its chunks back to the global heap
+    // the next time it is reset.
+    void purge() {
+        purge_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]]
+    ZoneStats getStats() const;
+};
+
+/**
+ * Tagged bump allocator in a zone. Allocating is as cheap as with a
+ * LinearArena: the zone only reads the counters of the arena when asked
+ * for statistics, so arenas used by different threads never contend.
+ */
+class ZoneArena {
+    Zone* zone;
+    ZoneTag tag;
+    LinearArena arena;
+    std::atomic<size_t> used{0};
+    std::atomic<size_t> reserved{0};
+    Uint32 purge_count;
+
+    void publish() {
+        used.store(arena.getUsed(), std::memory_order_relaxed);
+        reserved.store(arena.getReserved(), std::memory_order_relaxed);
+    }
+
+  public:
+    ZoneArena(Zone& zone, ZoneTag tag, size_t chunk_size = 64 * 1024);
+
+    ZoneArena(ZoneArena&& other) noexcept;
+
+    ZoneArena& operator=(const ZoneArena& other) = delete;
+
+    ~ZoneArena();
+
+    [[nodiscard]]
+    ZoneTag getTag() const {
+        return tag;
+    }
+
+    void* allocate(const size_t size, const size_t alignment) {
+        const auto data{arena.allocate(size, alignment)};
+        publish();
+        return data;
+    }
+
+    // Uninitialized storage for count objects that need no destructor.
+    template <typename T>
+    T* allocate(const size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>);
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Value-initialized array of count objects that need no destructor.
+    template <typename T>
+    std::span<T> allocateArray(const size_t count) {
+        const auto data{allocate<T>(count)};
+        std::uninitialized_value_construct_n(data, count);
+        return {data, count};
+    }
+
+    // Free everything allocated since the last reset.
+    void reset();
+
+    // Reset and give the chunks back to the global heap.
+    void release() {
+        arena.release();
+        publish();
+    }
+
+    [[nodiscard]]
+    size_t getUsed() const {
+        return used.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]]
+    size_t getReserved() const {
+        return reserved.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * Scratch memory of the renderer, reset at the start of every frame.
+ * Frames alternate between two purgable arenas, so that what one frame
+ * allocated stays valid while the next one is built, for a thread that
+ * still works on it.
+ */
+class FrameArena {
+    std::array<ZoneArena, 2> buffers;
+    size_t current{0};
+    // Most bytes a finished frame allocated.
+    size_t high_water{0};
+
+  public:
+    explicit FrameArena(Zone& zone)
+        : buffers{
+            ZoneArena{zone, ZoneTag::Purgable},
+            ZoneArena{zone, ZoneTag::Purgable},
+        } {
+    }
+
+    // Switch to the arena of the frame before last and free what it had.
+    ZoneArena& beginFrame() {
+        high_water = std::max(high_water, getUsed());
+        current ^= 1;
+        buffers[current].reset();
+        return buffers[current];
+    }
+
+    [[nodiscard]]
+    ZoneArena& get() {
+        return buffers[current];
+    }
+
+    // Bytes allocated in the current frame.
+    [[nodiscard]]
+    size_t getUsed() const {
+        return buffers[current].getUsed();
+    }
+
+    // Most bytes any frame allocated so far, the current one included.
+    [[nodiscard]]
+    size_t getHighWater() const {
+        return std::max(high_water, getUsed());
+    }
+};
+
+/**
+ * Growable array in an arena, for per-frame lists whose length is not
+ * known up front. Growing copies the elements to a block twice as large
+ * and leaves the old one to the arena, which wastes at most as much as
+ * the array holds.
+ */
+template <typename T>
+class ArenaVector {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    ZoneArena* arena{nullptr};
+    T* elements{nullptr};
+    size_t count{0};
+    size_t capacity{0};
+
+    void grow() {
+        const auto new_capacity{std::max(capacity * 2, size_t{16})};
+        const auto grown{arena->allocate<T>(new_capacity)};
+        std::copy_n(elements, count, grown);
+        elements = grown;
+        capacity = new_capacity;
+    }
+
+  public:
+    // Empty the array and take its elements from the arena from now on.
+    void clear(ZoneArena& new_arena) {
+        arena = &new_arena;
+        elements = nullptr;
+        count = 0;
+        capacity = 0;
+    }
+
+    void push_back(const T& element) {
+        if (count == capacity) {
+            grow();
+        }
+        elements[count++] = element;
+    }
+
+    [[nodiscard]]
+    size_t size() const {
+        return count;
+    }
+
+    [[nodiscard]]
+    bool empty() const {
+        return count == 0;
+    }
+
+    [[nodiscard]]
+    T* data() const {
+        return elements;
+    }
+
+    [[nodiscard]]
+    T* begin() const {
+        return elements;
+    }
+
+    [[nodiscard]]
+    T* end() const {
+        return elements + count;
+    }
+
+    T& operator[](const size_t index) const {
+        return elements[index];
+    }
+};
+
+[[nodiscard]]
+const char* zoneTagName(ZoneTag tag);
+
+// One line per tag with its memory and fragmentation.
+void printZoneStats(std::ostream& out, const ZoneStats& stats);